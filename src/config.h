@@ -24,7 +24,7 @@
 #define VER_BETA        0
 
 // Mapfile format
-#define MAP_FORMAT      320
+#define MAP_FORMAT      330
 
 // Uncomment this setting in a release build
 #define RELEASEBUILD
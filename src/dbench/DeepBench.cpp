@@ -0,0 +1,156 @@
+// -----------------------------------------------------------------------------
+// This file is part of DeepDrill
+//
+// A Mandelbrot generator based on perturbation and series approximation
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v3
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#include "DeepBench.h"
+#include "SlowDriller.h"
+#include "Driller.h"
+#include "Exception.h"
+#include "Logger.h"
+
+int main(int argc, char *argv[])
+{
+    return dd::DeepBench().main(argc, argv);
+}
+
+namespace dd {
+
+const char *
+DeepBench::optstring() const
+{
+    return ":va:";
+}
+
+const option *
+DeepBench::longopts() const
+{
+    static struct option long_options[] = {
+
+        { "verbose",  no_argument,       NULL, 'v' },
+        { "assets",   required_argument, NULL, 'a' },
+        { NULL,       0,                 NULL,  0  }
+    };
+
+    return long_options;
+}
+
+void
+DeepBench::syntax() const
+{
+    log::cout << "Usage: ";
+    log::cout << "deepbench [-v] [-a <path>] [<keyvalue>] <inputs>" << log::endl;
+    log::cout << log::endl;
+    log::cout << "       -v or --verbose   Run in verbose mode" << log::endl;
+    log::cout << "       -a or --assets    Optional path to asset files" << log::endl;
+}
+
+void
+DeepBench::checkArguments()
+{
+    // A location must be given
+    if (Options::getInputs(Format::INI).empty()) throw SyntaxError("No location is given");
+
+    // Drill all channels of a map file, which is saved to a temporary file
+    Options::files.outputs.push_back(fs::temp_directory_path() / "deepbench.map");
+}
+
+void
+DeepBench::run()
+{
+    /* The location is drilled once for each combination of the period check,
+     * the attractor check, and derivative tracking, i.e., once with each
+     * specialization of the delta loop. The measured time covers the delta
+     * loops only. Afterwards, the drill map is saved and loaded in all
+     * supported storage formats. All numbers depend on the machine. Hence,
+     * they are only comparable between runs on the same host.
+     */
+    log::cout << log::ralign("Location: ");
+    log::cout << Options::getInputs(Format::INI).front().filename().string() << log::endl;
+    log::cout << log::ralign("Map size: ");
+    log::cout << Options::drillmap.width << " x " << Options::drillmap.height << log::endl;
+    log::cout << log::ralign("Threads: ");
+    log::cout << isize(std::thread::hardware_concurrency()) << log::endl;
+    log::cout << log::vspace;
+
+    for (isize i = 0; i < 8; i++) {
+
+        Options::periodcheck.enable = i & 4;
+        Options::attractorcheck.enable = i & 2;
+        Options::drillmap.derivatives = i & 1;
+
+        auto elapsed = runDriller();
+
+        if (i == 0) {
+
+            log::cout << log::ralign("Driller: ");
+            log::cout << (SlowDriller::isPrecise(drillMap) || !Options::perturbation.enable ? "Standard precision" : "Perturbation") << log::endl;
+            log::cout << log::vspace;
+        }
+
+        auto flag = [](bool value) { return value ? "yes" : " no"; };
+        log::cout << "Period check: " << flag(i & 4);
+        log::cout << "   Attractor check: " << flag(i & 2);
+        log::cout << "   Derivatives: " << flag(i & 1);
+        log::cout << "   Delta loops: " << isize(elapsed.asMilliseconds()) << " ms" << log::endl;
+    }
+    log::cout << log::vspace;
+
+    for (auto tiled : { "no", "yes" }) {
+        for (auto precision : { "single", "half", "quantized" }) {
+
+            Options::parse("mapfile.tiled", tiled);
+            Options::parse("mapfile.precision", precision);
+
+            runMapfile(string(precision) + (string(tiled) == "yes" ? " (tiled)" : ""));
+        }
+    }
+
+    fs::remove(Options::files.outputs.front());
+}
+
+Time
+DeepBench::runDriller()
+{
+    if (!Options::flags.verbose) log::cout.mute();
+
+    // Start from scratch
+    drillMap.resize();
+
+    Time elapsed;
+    try { elapsed = Driller::run(drillMap); } catch (...) { log::cout.unmute(); throw; }
+
+    if (!Options::flags.verbose) log::cout.unmute();
+    return elapsed;
+}
+
+void
+DeepBench::runMapfile(const string &config)
+{
+    auto path = Options::files.outputs.front().string();
+
+    if (!Options::flags.verbose) log::cout.mute();
+
+    auto start = Time::now();
+    drillMap.save(path);
+    auto saved = Time::now();
+
+    DrillMap loaded;
+    loaded.load(path);
+    auto done = Time::now();
+
+    if (!Options::flags.verbose) log::cout.unmute();
+
+    log::cout << log::ralign(config + ": ");
+    log::cout << isize(fs::file_size(path)) << " bytes, ";
+    log::cout << "saved in " << isize((saved - start).asMilliseconds()) << " ms, ";
+    log::cout << "loaded in " << isize((done - saved).asMilliseconds()) << " ms" << log::endl;
+}
+
+}
@@ -0,0 +1,58 @@
+// -----------------------------------------------------------------------------
+// This file is part of DeepDrill
+//
+// A Mandelbrot generator based on perturbation and series approximation
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v3
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#pragma once
+
+#include "config.h"
+#include "Application.h"
+#include "DrillMap.h"
+
+namespace dd {
+
+class DeepBench : public Application {
+
+    // The drill map
+    DrillMap drillMap;
+
+
+    //
+    // Methods from Application
+    //
+
+public:
+
+    void run();
+
+private:
+
+    const char *appName() const { return "DeepBench"; }
+    const char *optstring() const;
+    const option *longopts() const;
+    bool isAcceptedInputFormat(Format format) const { return format == Format::INI; }
+    bool isAcceptedOutputFormat(Format format) const { return format == Format::MAP; }
+
+    void syntax() const;
+    void initialize() { };
+    void checkArguments();
+
+
+    //
+    // Auxiliary methods
+    //
+
+    // Drills the map with the current options and returns the time spent in the delta loops
+    Time runDriller();
+
+    // Saves and loads the drill map with the current mapfile options
+    void runMapfile(const string &config);
+};
+
+}
@@ -77,52 +77,36 @@ Coefficients::evaluateDerivate(const Coord &coord, const ExtendedComplex &delta,
 }
 
 void
-Approximator::compute(ReferencePoint &ref, isize numCoeff, isize depth)
+Approximator::init(isize num, isize depth)
 {
-    assert(numCoeff >= 2 && numCoeff <= 64);
-
-    auto limit = std::min(depth, (isize)ref.xn.size());
-
-    ProgressIndicator progress("Computing coefficients", limit);
+    assert(num >= 2 && num <= 64);
 
+    numCoeff = num;
     a.resize(depth, numCoeff);
+    a[0][0] = ExtendedComplex(1, 0);
+}
 
+void
+Approximator::compute(const ReferenceIteration &xn, isize i)
+{
     // Based on the formulas from:
     // https://fractalwiki.org/wiki/Series_approximation
 
-    a[0][0] = ExtendedComplex(1, 0);
-    for (isize i = 1; i < limit; i++) {
+    assert(i >= 1);
 
-        assert(i < (isize)ref.xn.size());
-        a[i][0] = a[i-1][0] * ref.xn[i-1].extended * (double)2;
-        a[i][0] += ExtendedComplex(1.0, 0.0);
-        a[i][0].reduce();
+    a[i][0] = a[i-1][0] * xn.extended * (double)2;
+    a[i][0] += ExtendedComplex(1.0, 0.0);
+    a[i][0].reduce();
 
-        for (isize j = 1; j < numCoeff; j++) {
+    for (isize j = 1; j < numCoeff; j++) {
 
-            a[i][j] = a[i-1][j] * ref.xn[i-1].extended * (double)2;
-            a[i][j].reduce();
+        a[i][j] = a[i-1][j] * xn.extended * (double)2;
+        a[i][j].reduce();
 
-            for (isize l = 0; l < j; l++) {
-                a[i][j] += a[i-1][l] * a[i-1][j-1-l];
-                a[i][j].reduce();
-            }
+        for (isize l = 0; l < j; l++) {
+            a[i][j] += a[i-1][l] * a[i-1][j-1-l];
+            a[i][j].reduce();
         }
-
-        // Update the progress counter
-        if (i % 1024 == 0) progress.step(1024);
-    }
-
-    progress.done();
-
-    if (Options::flags.verbose) {
-
-        log::cout << log::vspace;
-        log::cout << log::ralign("Coefficients: ");
-        log::cout << Options::approximation.coefficients << log::endl;
-        log::cout << log::ralign("Approximation tolerance: ");
-        log::cout << Options::approximation.tolerance << log::endl;
-        log::cout << log::vspace;
     }
 }
 
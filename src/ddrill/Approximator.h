@@ -36,6 +36,9 @@ class Approximator {
     // Coefficient array
     Coefficients a;
 
+    // Number of coefficients
+    isize numCoeff = 0;
+
 
     //
     // Initializing
@@ -52,7 +55,11 @@ public:
 
 public:
 
-    void compute(ReferencePoint &ref, isize num, isize depth);
+    // Prepares the coefficient array
+    void init(isize num, isize depth);
+
+    // Computes the coefficients for a single iteration from the previous one
+    void compute(const ReferenceIteration &xn, isize iteration);
 
 
     //
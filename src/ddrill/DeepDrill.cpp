@@ -10,7 +10,6 @@
 // -----------------------------------------------------------------------------
 
 #include "DeepDrill.h"
-#include "SlowDriller.h"
 #include "Driller.h"
 #include "DrillMap.h"
 #include "MapAnalyzer.h"
@@ -27,7 +26,7 @@ namespace dd {
 const char *
 DeepDrill::optstring() const
 {
-    return ":vba:o:";
+    return ":vba:o:t:";
 }
 
 const option *
@@ -39,6 +38,7 @@ DeepDrill::longopts() const
         { "verbose",  no_argument,       NULL, 'v' },
         { "assets",   required_argument, NULL, 'a' },
         { "output",   required_argument, NULL, 'o' },
+        { "tile",     required_argument, NULL, 't' },
         { NULL,       0,                 NULL,  0  }
     };
 
@@ -49,12 +49,13 @@ void
 DeepDrill::syntax() const
 {
     log::cout << "Usage: ";
-    log::cout << "deepdrill [-bv] [-a <path>] -o <output> [<keyvalue>] <inputs>" << log::endl;
+    log::cout << "deepdrill [-bv] [-a <path>] [-t <tile>] -o <output> [<keyvalue>] <inputs>" << log::endl;
     log::cout << log::endl;
     log::cout << "       -b or --batch     Run in batch mode" << log::endl;
     log::cout << "       -v or --verbose   Run in verbose mode" << log::endl;
     log::cout << "       -a or --assets    Optional path to asset files" << log::endl;
     log::cout << "       -o or --output    Output file" << log::endl;
+    log::cout << "       -t or --tile      Drill a portion of the map (\"i/n\" or \"x,y,w,h\")" << log::endl;
 }
 
 bool
@@ -72,9 +73,6 @@ DeepDrill::isAcceptedOutputFormat(Format format) const
 void
 DeepDrill::checkArguments()
 {
-    // At most one map file must be given
-    if (Options::getInputs(Format::MAP).size() > 1) throw SyntaxError("More than one map file is given");
-
     // At least one output file must be given
     if (Options::files.outputs.size() < 1) throw SyntaxError("No output file is given");
 }
@@ -87,8 +85,28 @@ DeepDrill::run()
 
     if (!Options::getInputs(Format::MAP).empty()) {
 
-        // Load the drill map from disk
-        drillMap.load(Options::getInputs(Format::MAP).front());
+        auto maps = Options::getInputs(Format::MAP);
+
+        // Load the drill map from disk (tiled maps at the requested mip level)
+        drillMap.load(maps.front(), Options::mapfile.level);
+
+        // Merge in all other maps (shards drilled with the 'tile' option)
+        for (usize i = 1; i < maps.size(); i++) {
+
+            DrillMap shard;
+            shard.load(maps[i], Options::mapfile.level);
+
+            ProgressIndicator progress("Merging " + maps[i].filename().string());
+            drillMap.merge(shard);
+        }
+
+        // Make sure that the shards cover the merged drill area without gaps
+        if (maps.size() > 1 && drillMap.hasDrillResults()) {
+
+            if (auto holes = drillMap.unprocessed(); holes) {
+                throw Exception("The map files leave " + std::to_string(holes) + " pixels uncovered");
+            }
+        }
 
         // Generate outputs
         generateOutputs();
@@ -98,7 +116,7 @@ DeepDrill::run()
         BatchProgressIndicator progress("Drilling",  Options::files.outputs.front());
 
         // Run the driller
-        runDriller();
+        Driller::run(drillMap);
 
         // Generate outputs
         generateOutputs();
@@ -108,21 +126,6 @@ DeepDrill::run()
     }
 }
 
-void
-DeepDrill::runDriller()
-{
-    if (Options::perturbation.enable) {
-
-        Driller driller(drillMap);
-        driller.drill();
-
-    } else {
-
-        SlowDriller driller(drillMap);
-        driller.drill();
-    }
-}
-
 void
 DeepDrill::generateOutputs()
 {
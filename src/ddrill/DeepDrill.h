@@ -52,7 +52,6 @@ private:
     // Auxiliary methods
     //
 
-    void runDriller();
     void generateOutputs();
 };
 
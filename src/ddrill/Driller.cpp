@@ -10,17 +10,50 @@
 // -----------------------------------------------------------------------------
 
 #include "Driller.h"
+#include "SlowDriller.h"
+#include "Tuner.h"
 #include "Options.h"
 #include "Logger.h"
 #include "ProgressIndicator.h"
 
-#include <random>
+#include <thread>
 
 namespace dd {
 
-Driller::Driller(DrillMap &m) : map(m)
+Driller::Driller(DrillMap &m, Time d) : map(m), deadline(d)
 {
+    // Streaming only pays off if multiple threads can run in parallel
+    streaming = Options::perturbation.streaming && std::thread::hardware_concurrency() > 1;
+}
+
+Time
+Driller::run(DrillMap &map)
+{
+    // Start the clock if drilling is time-limited (tuning counts, too)
+    Time deadline;
+    if (Options::perturbation.deadline > 0) {
+        deadline = Time::now() + Time::seconds(float(Options::perturbation.deadline));
+    }
+
+    /* Shallow maps are drilled directly in standard precision. Autotuning,
+     * interpolation, and glitch inpainting only apply to the perturbation
+     * driller and are skipped in this case. The time budget applies to both.
+     */
+    if (Options::perturbation.enable && !SlowDriller::isPrecise(map)) {
+
+        // Optimize the drill parameters with a downscaled pilot map
+        if (Options::autotune.enable) Tuner(deadline).tune();
+
+        Driller driller(map, deadline);
+        driller.drill();
+        return driller.loopTime;
 
+    } else {
+
+        SlowDriller driller(map, deadline);
+        driller.drill();
+        return driller.loopTime;
+    }
 }
 
 void
@@ -29,8 +62,8 @@ Driller::drill()
     std::vector<Coord> remaining;
     std::vector<Coord> glitches;
 
-    auto width = Options::drillmap.width;
-    auto height = Options::drillmap.height;
+    auto width = map.areaLR.x - map.areaUL.x + 1;
+    auto height = map.areaLR.y - map.areaUL.y + 1;
 
     // Determine the number of tolerated glitched pixels
     isize threshold = width * height * Options::perturbation.badpixels;
@@ -57,10 +90,16 @@ Driller::drill()
         log::cout << Options::location.depth << log::endl;
         log::cout << log::ralign("Escape radius: ");
         log::cout << Options::location.escape << log::endl;
+        log::cout << log::ralign("Bailout radius: ");
+        log::cout << std::min(Options::location.bailout, Options::location.escape) << log::endl;
         log::cout << log::endl;
         log::cout << log::ralign("Map size: ");
         log::cout << Options::drillmap.width << " x " << Options::drillmap.height;
         log::cout << log::endl;
+        if (map.isShard()) {
+            log::cout << log::ralign("Drill area: ");
+            log::cout << map.areaUL << " - " << map.areaLR << log::endl;
+        }
         log::cout << log::ralign("Image size: ");
         log::cout << Options::image.width << " x " << Options::image.height;
         log::cout << (Options::lighting.enable ? " (3D)" : " (2D)") << log::endl;
@@ -73,22 +112,37 @@ Driller::drill()
         // log::cout << (Options::distance.threshold() > 0.0) << log::endl;
         log::cout << log::ralign("Area checking: ");
         log::cout << Options::areacheck.enable << log::endl;
+        log::cout << log::ralign("Derivatives: ");
+        log::cout << Options::drillmap.derivatives << log::endl;
+        log::cout << log::ralign("Mirroring: ");
+        log::cout << (map.mirrorSum >= 0) << log::endl;
         log::cout << log::ralign("Period checking: ");
         log::cout << Options::periodcheck.enable << log::endl;
         log::cout << log::ralign("Attractor checking: ");
         log::cout << Options::attractorcheck.enable << log::endl;
+        log::cout << log::ralign("Interpolation: ");
+        log::cout << Options::interpolation.enable << log::endl;
         log::cout << log::vspace;
     }
 
     // Collect all pixel coordinates to be drilled at
     collectCoordinates(remaining);
 
+    // Drill coarse lattices first to get a complete map when time runs out
+    if (deadline.ticks) map.sortCoarseToFine(remaining);
+
     // Enter the main loop
     for (isize round = 1; round <= Options::perturbation.rounds; round++) {
 
         // Exit once enough pixels have been computed
         if ((isize)remaining.size() <= threshold) break;
 
+        // Exit if the time budget has been used up
+        if (expired()) break;
+
+        // Exit if the remaining glitches can be resolved in the final pass
+        if (round > 1 && Options::perturbation.inpaint && isScattered(remaining)) break;
+
         log::cout << log::vspace;
         log::cout << "Round " << round;
         if (Options::flags.verbose) log::cout << " / " << Options::perturbation.rounds;
@@ -97,43 +151,67 @@ Driller::drill()
 
         // Select a reference point
         ref = pickReference(glitches);
-        
-        // Drill the reference point
-        drill(ref);
-        
-        if (Options::flags.verbose) {
+        frontier = 0;
+        complete = false;
 
-            log::cout << log::vspace;
-            log::cout << log::ralign("Reference point: ");
-            log::cout << ref.coord << log::endl;
-            log::cout << log::ralign("Perturbation tolerance: ");
-            log::cout << Options::perturbation.tolerance << log::endl;
-            log::cout << log::ralign("Maximum depth: ");
-            log::cout << Options::location.depth << log::endl;
-            log::cout << log::ralign("Actual depth: ");
-            log::cout << ref.xn.size() << log::endl;
-            log::cout << log::vspace;
+        // Compute the reference orbit (in the background in streaming mode)
+        std::exception_ptr error;
+        std::jthread producer;
+
+        if (streaming) {
+
+            producer = std::jthread([this, &error]() {
+
+                try { drill(ref); } catch (...) { error = std::current_exception(); }
+            });
+
+        } else {
+
+            drill(ref);
         }
-        
+
+        auto report = [&]() {
+
+            if (Options::flags.verbose) {
+
+                log::cout << log::vspace;
+                log::cout << log::ralign("Reference point: ");
+                log::cout << ref.coord << log::endl;
+                log::cout << log::ralign("Perturbation tolerance: ");
+                log::cout << Options::perturbation.tolerance << log::endl;
+                log::cout << log::ralign("Maximum depth: ");
+                log::cout << Options::location.depth << log::endl;
+                log::cout << log::ralign("Actual depth: ");
+                log::cout << frontier << log::endl;
+                log::cout << log::ralign("Period: ");
+                log::cout << ref.period << log::endl;
+                log::cout << log::ralign("Stored iterations: ");
+                log::cout << ref.xn.size() << log::endl;
+                log::cout << log::vspace;
+            }
+        };
+        if (!producer.joinable()) report();
+
         // If series approximation is enabled...
         if (Options::approximation.enable) {
-        
-            // Compute the coefficients
-            approximator.compute(ref, Options::approximation.coefficients, Options::location.depth);
 
             // Pick the probe points
             pickProbePoints(probePoints);
-            
-            // Drill the probe points
+
+            // Compute the coefficients and drill the probe points
             ref.skipped = drillProbePoints(probePoints);
 
             // Make sure that at least one iteration of the main loop is executed
-            if (ref.skipped == isize(ref.xn.size())) ref.skipped -= 2;
+            if (ref.skipped == frontier) ref.skipped -= 2;
             if (ref.skipped < 0) ref.skipped = 0;
 
             if (Options::flags.verbose) {
 
                 log::cout << log::vspace;
+                log::cout << log::ralign("Coefficients: ");
+                log::cout << Options::approximation.coefficients << log::endl;
+                log::cout << log::ralign("Approximation tolerance: ");
+                log::cout << Options::approximation.tolerance << log::endl;
                 log::cout << log::ralign("Skippable iterations: ");
                 log::cout << ref.skipped << log::endl;
                 log::cout << log::vspace;
@@ -141,8 +219,20 @@ Driller::drill()
         }
 
         // Drill the remaining pixels
-        drill(remaining, glitches);
+        if (round == 1 && Options::interpolation.enable) {
+            interpolate(remaining, glitches);
+        } else {
+            drill(remaining, glitches);
+        }
         remaining = glitches;
+
+        // Wait for the reference orbit to complete
+        if (producer.joinable()) {
+
+            producer.join();
+            if (error) std::rethrow_exception(error);
+            report();
+        }
         
         if (Options::flags.verbose) {
             
@@ -153,8 +243,18 @@ Driller::drill()
         }        
     }
 
+    // Resolve the remaining glitches without another round
+    if (Options::perturbation.inpaint && !expired()) resolve(remaining);
+
+    // Fill the pixels that couldn't be drilled in time
+    auto timeout = expired();
+    if (timeout) map.fill();
+
+    // Fill the rows that have been skipped due to symmetry
+    map.mirror();
+
     log::cout << log::vspace;
-    log::cout << "All rounds completed: ";
+    log::cout << (timeout ? "Deadline reached: " : "All rounds completed: ");
     log::cout << (isize)remaining.size() << " unresolved";
     log::cout << log::endl << log::endl;
 }
@@ -175,14 +275,15 @@ Driller::collectCoordinates(std::vector<dd::Coord> &remaining)
      * all locations need to be drilled.
      */
 
-    auto width = Options::drillmap.width;
-    auto height = Options::drillmap.height;
+    auto width = map.areaLR.x - map.areaUL.x + 1;
+    auto height = map.areaLR.y - map.areaUL.y + 1;
 
     // If area checking if disabled, drill everywhere
     if (!Options::areacheck.enable) {
 
-        for (isize y = 0; y < height; y++) {
-            for (isize x = 0; x < width; x++) {
+        for (isize y = map.areaUL.y; y <= map.areaLR.y; y++) {
+            if (map.isMirrored(y)) continue;
+            for (isize x = map.areaUL.x; x <= map.areaLR.x; x++) {
                 remaining.push_back(Coord(x,y));
             }
         }
@@ -206,8 +307,12 @@ Driller::collectCoordinates(std::vector<dd::Coord> &remaining)
     }
 
     // Collect all drill coordinates
-    for (isize y = 0; y < height; y++) {
-        for (isize x = 0; x < width; x++) {
+    for (isize y = map.areaUL.y; y <= map.areaLR.y; y++) {
+
+        // Skip all rows that are computed by mirroring
+        if (map.isMirrored(y)) { progress.step(width); continue; }
+
+        for (isize x = map.areaUL.x; x <= map.areaLR.x; x++) {
 
             if (hit) {
 
@@ -233,24 +338,158 @@ Driller::collectCoordinates(std::vector<dd::Coord> &remaining)
 ReferencePoint
 Driller::pickReference(const std::vector<Coord> &glitches)
 {
-    // Current strategy: In the first round, the center is used as reference
-    // point. In all other rounds, the reference point is selected randomly
-    // among all glitch points.
+    // Current strategy: In the first round, the center of the drill area is
+    // used as reference point, unless a minibrot nucleus has been found. In
+    // all other rounds, the reference point is selected randomly among all
+    // glitch points.
 
     bool firstRound = glitches.empty();
 
     if (firstRound) {
 
-        auto coord = Coord(map.width / 2, map.height / 2);
+        if (Options::perturbation.nucleus) {
+            if (auto nucleus = findNucleus(); nucleus) return *nucleus;
+        }
+
+        auto coord = Coord(isize(map.areaUL.x + map.areaLR.x) / 2,
+                           isize(map.areaUL.y + map.areaLR.y) / 2);
         return ReferencePoint(coord, map.translate(coord));
 
     } else {
         
-        auto coord = glitches[rand() % glitches.size()];
+        auto coord = glitches[rng() % glitches.size()];
         return ReferencePoint(coord, map.translate(coord));
     }
 }
 
+std::optional<ReferencePoint>
+Driller::findNucleus()
+{
+    ProgressIndicator progress("Searching nucleus", Options::location.depth);
+
+    auto center = Coord(isize(map.areaUL.x + map.areaLR.x) / 2,
+                        isize(map.areaUL.y + map.areaLR.y) / 2);
+    auto c0 = map.translate(center);
+
+    /* Step 1: Determine the period of the dominant minibrot. A minibrot of
+     * period p has a nucleus c with z_p(c) = 0. The orbit of the area center
+     * is iterated together with its derivative until the disk covering the
+     * drill area (probably) contains a point with z_p = 0, i.e., until
+     * |z_p| < |dz_p| * radius (ball method).
+     */
+    auto w = map.areaLR.x - map.areaUL.x + 1;
+    auto h = map.areaLR.y - map.areaUL.y + 1;
+    auto radius = map.pixelDelta * (0.5 * std::sqrt(double(w * w + h * h)));
+    auto radius2 = radius * radius;
+    radius2.reduce();
+
+    PrecisionComplex z = c0;
+    ExtendedComplex dz = ExtendedComplex(1.0, 0.0);
+    isize period = 0;
+
+    for (isize i = 1; i < Options::location.depth; i++) {
+
+        auto zn = ExtendedComplex(z);
+        zn.reduce();
+        auto norm = zn.norm();
+        auto bound = dz.norm() * radius2;
+        bound.reduce();
+
+        if (norm < bound) { period = i; break; }
+        if (norm > 4.0) break;
+
+        dz *= zn * 2.0;
+        dz += ExtendedComplex(1.0, 0.0);
+        dz.reduce();
+
+        z *= z;
+        z += c0;
+
+        if (i % 1024 == 0) {
+            if (Options::stop) throw UserInterruptException();
+            progress.step(1024);
+        }
+    }
+
+    if (!period) { progress.done("Not found"); return { }; }
+
+    /* Step 2: Refine the nucleus with Newton's method, i.e., iterate
+     * c := c - z_p(c) / z_p'(c) until the correction is a tiny fraction of
+     * the pixel size.
+     */
+    auto epsilon = map.pixelDelta * 1e-6;
+    auto epsilon2 = epsilon * epsilon;
+    epsilon2.reduce();
+
+    PrecisionComplex c = c0;
+    bool converged = false;
+
+    for (isize step = 0; step < 64 && !converged; step++) {
+
+        PrecisionComplex zp = c;
+        PrecisionComplex dp = PrecisionComplex(1.0, 0.0);
+
+        for (isize i = 1; i < period; i++) {
+
+            dp *= zp * 2.0;
+            dp += PrecisionComplex(1.0, 0.0);
+            zp *= zp;
+            zp += c;
+
+            if (Options::stop) throw UserInterruptException();
+        }
+
+        auto delta = zp / dp;
+        c -= delta;
+
+        auto correction = ExtendedComplex(delta);
+        correction.reduce();
+        auto norm = correction.norm();
+        converged = norm < epsilon2;
+    }
+
+    if (!converged) { progress.done("Newton failed"); return { }; }
+
+    // Step 3: Make sure that the nucleus is located inside the drill area
+    auto offset = c - c0;
+    mpf_class dx = offset.re / map.mpfPixelDelta;
+    mpf_class dy = offset.im / map.mpfPixelDelta;
+
+    if (abs(dx) > w || abs(dy) > h) { progress.done("Outside"); return { }; }
+
+    auto coord = map.translate(c);
+    if (coord.x < map.areaUL.x || coord.x > map.areaLR.x ||
+        coord.y < map.areaUL.y || coord.y > map.areaLR.y) {
+
+        progress.done("Outside");
+        return { };
+    }
+
+    progress.done("Period " + std::to_string(period));
+
+    ReferencePoint result(coord, c);
+    result.offset = ExtendedComplex(map.translate(coord) - c);
+    result.offset.reduce();
+
+    return result;
+}
+
+ExtendedComplex
+Driller::delta(const Coord &point) const
+{
+    /* The offset must only be added if it is nonzero. A zero offset or a zero
+     * distance has exponent 0. Adding it rescales the other operand to this
+     * exponent, which flushes deltas below 1e-308 to zero.
+     */
+    if (ref.isCentered()) return map.distance(point, ref.coord);
+    if (point == ref.coord) return ref.offset;
+
+    auto result = map.distance(point, ref.coord) + ref.offset;
+    result.reduce();
+
+    return result;
+}
+
 void
 Driller::pickProbePoints(std::vector<Coord> &probes)
 {
@@ -268,7 +507,16 @@ Driller::pickProbePoints(std::vector<Coord> &probes)
 void
 Driller::drill(ReferencePoint &r)
 {
-    ProgressIndicator progress("Computing reference orbit", Options::location.depth);
+    // Only show a progress indicator if no other work is done in parallel
+    std::optional<ProgressIndicator> progress;
+    if (!streaming) {
+        progress.emplace("Computing reference orbit", Options::location.depth);
+    }
+
+    // Reserve enough space to make sure that the orbit is never relocated
+    r.xn.clear();
+    r.xn.reserve(Options::location.depth);
+    r.period = 0;
 
     PrecisionComplex z = r.location;
     PrecisionComplex d0 { 1.0, 0.0 };
@@ -277,7 +525,11 @@ Driller::drill(ReferencePoint &r)
     double escape = Options::location.escape * Options::location.escape;
 
     r.xn.push_back(ReferenceIteration(z, Options::perturbation.tolerance));
-        
+
+    // Iteration the orbit is compared with to detect periodicity
+    isize checkpoint = 0;
+    isize nextCheckpoint = 16;
+
     for (isize i = 1; i < Options::location.depth; i++) {
 
         // Compute derivative
@@ -295,113 +547,366 @@ Driller::drill(ReferencePoint &r)
         // Perform the escape check
         if (norm >= escape) {
 
-            auto nv = z / dn;
-            nv.normalize();
-
             r.escaped = true;
-            map.set(r.coord, {
+            if (r.isCentered()) map.set(r.coord, {
                 .result     = DR_ESCAPED,
                 .last       = (i32)i,
-                .zn         = StandardComplex(z),
-                .derivative = StandardComplex(dn),
-                .normal     = StandardComplex(nv) } );
+                .zn         = ExtendedComplex(z),
+                .derivative = ExtendedComplex(dn) } );
+
+            publish(r.xn.size(), true);
             return;
         }
-        
-        // Update the progress counter
+
+        // Perform the period check
+        if (r.xn[i].matches(r.xn[checkpoint])) {
+
+            // Only keep the preperiod and a single period
+            if ((r.period = r.findPeriod(i - checkpoint))) {
+
+                r.xn.pop_back();
+                break;
+            }
+        }
+        if (i == nextCheckpoint) {
+
+            checkpoint = i;
+            nextCheckpoint = i + i / 2;
+        }
+
+        // Update the progress counter and hand out the computed iterations
         if (i % 1024 == 0) {
-            if (Options::stop) throw UserInterruptException();
-            progress.step(1024);
+
+            publish(r.xn.size());
+
+            if (Options::stop) {
+
+                publish(r.xn.size(), true);
+                throw UserInterruptException();
+            }
+            if (expired()) {
+
+                publish(r.xn.size(), true);
+                return;
+            }
+            if (progress) progress->step(1024);
         }
     }
 
     // This point is inside the Mandelbrot set
-    map.set(r.coord, {
+    if (r.isCentered()) map.set(r.coord, {
         .result     = DR_MAX_DEPTH_REACHED,
         .last       = (i32)Options::location.depth });
+
+    publish(r.period ? Options::location.depth : r.xn.size(), true);
+}
+
+void
+Driller::publish(isize count, bool done)
+{
+    {   std::lock_guard<std::mutex> lock(frontierMutex);
+
+        frontier.store(count, std::memory_order_release);
+        if (done) complete.store(true, std::memory_order_release);
+    }
+    frontierCond.notify_all();
 }
 
 isize
-Driller::drillProbePoints(std::vector<Coord> &probes)
+Driller::await(isize iteration)
 {
-    ProgressIndicator progress("Checking probe points", probes.size());
-    
-    isize minValid = Options::location.depth - 1;
-    
-    for (auto &probe : probes) {
+    // Fast path: The requested iteration is already available
+    if (complete.load(std::memory_order_acquire)) return frontier;
+    if (auto count = frontier.load(std::memory_order_acquire); count > iteration) return count;
 
-        isize valid = drillProbePoint(probe);
-        minValid = std::min(minValid, valid);
+    // Slow path: Wait for the reference orbit to catch up
+    std::unique_lock<std::mutex> lock(frontierMutex);
+    frontierCond.wait(lock, [&]() { return frontier > iteration || complete; });
 
-        if (Options::stop) throw UserInterruptException();
-        progress.step();
-    }
-    
-    return minValid;
+    return frontier;
 }
 
 isize
-Driller::drillProbePoint(Coord &probe)
+Driller::drillProbePoints(std::vector<Coord> &probes)
 {
-    ExtendedComplex d0 = map.distance(probe, ref.coord);
-    ExtendedComplex dn = d0;
+    ProgressIndicator progress("Computing coefficients", Options::location.depth);
 
-    isize iteration = 0;
+    /* The coefficients are computed iteration by iteration while all probe
+     * points are iterated in lock-step. Once the approximation fails for a
+     * single probe point, no further coefficients are needed.
+     */
     auto tolerance = ExtendedDouble(Options::approximation.tolerance);
-    
-    // The depth of the reference point limits how deep we can drill
-    isize limit = ref.xn.size();
-    
-    // Enter the main loop
-    while (++iteration < limit) {
+    auto depth = Options::location.depth;
 
-        dn *= ref.xn[iteration - 1].extended2 + dn;
-        dn += d0;
-        dn.reduce();
-                
-        auto approx = approximator.evaluate(probe, d0, iteration);
-        auto error = (approx - dn).norm() / dn.norm();
-        error.reduce();
+    std::vector<ExtendedComplex> d0, dn;
+    for (auto &probe : probes) {
+
+        d0.push_back(delta(probe));
+        dn.push_back(d0.back());
+    }
+
+    approximator.init(Options::approximation.coefficients, depth);
+
+    isize iteration = 1;
+    for (; iteration < depth; iteration++) {
+
+        // The depth of the reference point limits how deep we can drill
+        if (await(iteration) <= iteration) break;
+
+        // Periodic orbits are only accessible after completion
+        auto &xn = ref.xn[complete ? ref.index(iteration - 1) : iteration - 1];
+
+        approximator.compute(xn, iteration);
+
+        for (usize i = 0; i < probes.size(); i++) {
+
+            dn[i] *= xn.extended2 + dn[i];
+            dn[i] += d0[i];
+            dn[i].reduce();
+
+            auto approx = approximator.evaluate(probes[i], d0[i], iteration);
+            auto error = (approx - dn[i]).norm() / dn[i].norm();
+            error.reduce();
 
-        if (error > tolerance) {
-            return iteration < 4 ? 0 : iteration - 4;
+            if (error > tolerance) {
+                return iteration < 4 ? 0 : iteration - 4;
+            }
+        }
+
+        // Update the progress counter
+        if (iteration % 1024 == 0) {
+            if (Options::stop) throw UserInterruptException();
+            if (expired()) break;
+            progress.step(1024);
         }
     }
-    return limit;
+
+    return std::min(depth - 1, iteration);
 }
 
 void
 Driller::drill(const std::vector<Coord> &remaining, std::vector<Coord> &glitches)
 {
     ProgressIndicator progress("Computing delta orbits", remaining.size());
-    
+
+    // Select the delta loop matching the enabled features
+    using Kernel = void (Driller::*)(const Coord &, std::vector<Coord> &);
+    static constexpr Kernel kernels[8] = {
+
+        &Driller::drill<false, false, false>, &Driller::drill<false, false, true>,
+        &Driller::drill<false, true, false>,  &Driller::drill<false, true, true>,
+        &Driller::drill<true, false, false>,  &Driller::drill<true, false, true>,
+        &Driller::drill<true, true, false>,   &Driller::drill<true, true, true>
+    };
+    auto kernel = kernels[Options::periodcheck.enable << 2 |
+                          Options::attractorcheck.enable << 1 |
+                          Options::drillmap.derivatives];
+
+    // Distribute the pixels among multiple threads in chunks
+    auto numThreads = isize(std::max(1U, std::thread::hardware_concurrency()));
+    auto count = isize(remaining.size());
+    auto chunkSize = isize(64);
+
+    std::vector<std::vector<Coord>> results(numThreads);
+    std::atomic<isize> next = 0;
+    auto start = Time::now();
+
+    auto worker = [&](isize nr) {
+
+        while (!Options::stop && !expired()) {
+
+            auto first = next.fetch_add(chunkSize);
+            if (first >= count) break;
+            auto last = std::min(first + chunkSize, count);
+
+            for (isize i = first; i < last; i++) {
+                (this->*kernel)(remaining[i], results[nr]);
+            }
+            progress.step(last - first);
+        }
+    };
+
+    {   std::vector<std::jthread> threads;
+        for (isize nr = 1; nr < numThreads; nr++) threads.push_back(std::jthread(worker, nr));
+        worker(0);
+    }
+    loopTime += Time::now() - start;
+    if (Options::stop) throw UserInterruptException();
+
+    // Collect all glitches in their original order
     glitches.clear();
-    for (unsigned int i = 0; i < remaining.size(); i++) {
-        
-        drill(remaining[i], glitches);
-        
-        if (Options::stop) throw UserInterruptException();
-        progress.step(1);
+    for (auto &it : results) glitches.insert(glitches.end(), it.begin(), it.end());
+
+    // Pixels that haven't been drilled in time remain unresolved
+    if (auto first = next.load(); first < count) {
+        glitches.insert(glitches.end(), remaining.begin() + first, remaining.end());
     }
+    std::sort(glitches.begin(), glitches.end(), [](const Coord &a, const Coord &b) {
+        return a.y < b.y || (a.y == b.y && a.x < b.x);
+    });
 }
 
 void
+Driller::interpolate(const std::vector<Coord> &remaining, std::vector<Coord> &glitches)
+{
+    /* The drill area is superimposed with a coarse grid. In the first step,
+     * the corners and the center of each grid cell are drilled. Afterwards,
+     * all cells are interpolated bilinearly if they are located far away from
+     * the Mandelbrot set and the drilled center matches the interpolated
+     * value. All other pixels are drilled as usual.
+     */
+    auto cellsize = Options::interpolation.cellsize;
+    auto width = map.areaLR.x - map.areaUL.x + 1;
+    auto height = map.areaLR.y - map.areaUL.y + 1;
+
+    // Collect the x and y coordinates of all grid lines
+    std::vector<isize> xs, ys;
+    for (isize x = map.areaUL.x; x < map.areaLR.x; x += cellsize) xs.push_back(x);
+    for (isize y = map.areaUL.y; y < map.areaLR.y; y += cellsize) ys.push_back(y);
+    xs.push_back(map.areaLR.x);
+    ys.push_back(map.areaLR.y);
+
+    // Mark all cell corners and cell centers
+    std::vector<bool> mask(width * height);
+    auto index = [&](isize x, isize y) { return (y - map.areaUL.y) * width + (x - map.areaUL.x); };
+
+    for (usize j = 0; j < ys.size(); j++) {
+        for (usize i = 0; i < xs.size(); i++) {
+
+            mask[index(xs[i], ys[j])] = true;
+            if (i > 0 && j > 0) mask[index((xs[i-1] + xs[i]) / 2, (ys[j-1] + ys[j]) / 2)] = true;
+        }
+    }
+
+    // Drill the grid points
+    std::vector<Coord> grid, rest, glitches1, glitches2;
+    for (const auto &it : remaining) {
+        (mask[index(it.x, it.y)] ? grid : rest).push_back(it);
+    }
+    drill(grid, glitches1);
+
+    // Wait until the reference point has been written into the map
+    await(Options::location.depth);
+    map.derive();
+
+    /* A pixel is far away from the Mandelbrot set if the distance estimate
+     * exceeds 2 * sqrt(2) times the cell size. Since the estimate is accurate
+     * up to a factor of 4, no point of the Mandelbrot set is closer to the
+     * corner than half of the cell's diagonal.
+     */
+    auto minDist = 2.0 * std::sqrt(2.0) * cellsize;
+    auto isSmooth = [&](isize x, isize y) {
+        auto i = y * map.width + x;
+        return map.resultMap[i] == DR_ESCAPED && map.distMap[i] >= minDist;
+    };
+
+    isize cells = 0;
+    for (usize j = 1; j < ys.size(); j++) {
+        for (usize i = 1; i < xs.size(); i++) {
+
+            auto x0 = xs[i-1], x1 = xs[i], xc = (x0 + x1) / 2;
+            auto y0 = ys[j-1], y1 = ys[j], yc = (y0 + y1) / 2;
+
+            if (!isSmooth(x0, y0) || !isSmooth(x1, y0) ||
+                !isSmooth(x0, y1) || !isSmooth(x1, y1) || !isSmooth(xc, yc)) continue;
+
+            // Compare the drilled cell center with the interpolated value
+            auto nitcnt = [&](isize x, isize y) { return map.nitcntMap[y * map.width + x]; };
+            auto expected = (nitcnt(x0, y0) + nitcnt(x1, y0) + nitcnt(x0, y1) + nitcnt(x1, y1)) / 4;
+            if (std::abs(nitcnt(xc, yc) - expected) > Options::interpolation.tolerance) continue;
+
+            map.interpolate(Coord(x0, y0), Coord(x1, y1));
+            cells++;
+        }
+    }
+
+    // Drill all pixels that haven't been interpolated
+    std::vector<Coord> pending;
+    for (const auto &it : rest) {
+        if (map.resultMap[it.y * map.width + it.x] == DR_UNPROCESSED) pending.push_back(it);
+    }
+    drill(pending, glitches2);
+
+    if (Options::flags.verbose) {
+
+        log::cout << log::vspace;
+        log::cout << log::ralign("Grid points: ");
+        log::cout << grid.size() << log::endl;
+        log::cout << log::ralign("Interpolated cells: ");
+        log::cout << cells << " / " << isize((xs.size() - 1) * (ys.size() - 1)) << log::endl;
+        log::cout << log::vspace;
+    }
+
+    // Collect all glitches in their original order
+    glitches = glitches1;
+    glitches.insert(glitches.end(), glitches2.begin(), glitches2.end());
+    std::sort(glitches.begin(), glitches.end(), [](const Coord &a, const Coord &b) {
+        return a.y < b.y || (a.y == b.y && a.x < b.x);
+    });
+}
+
+bool
+Driller::isScattered(const std::vector<Coord> &glitches) const
+{
+    for (const auto &it : glitches) {
+        for (isize y = it.y - 1; y <= it.y + 1; y++) {
+
+            if (y < map.areaUL.y || y > map.areaLR.y) continue;
+
+            for (isize x = it.x - 1; x <= it.x + 1; x++) {
+
+                if (x < map.areaUL.x || x > map.areaLR.x || (x == it.x && y == it.y)) continue;
+                if (map.resultMap[y * map.width + x] == DR_GLITCH) return false;
+            }
+        }
+    }
+    return true;
+}
+
+void
+Driller::resolve(std::vector<Coord> &glitches)
+{
+    /* Another round requires a new reference orbit in high precision, which
+     * doesn't pay off for a few scattered glitches. Instead, each glitch is
+     * replaced by the average of its resolved neighbors. Glitches with less
+     * than four resolved neighbors remain unresolved.
+     */
+    map.derive();
+
+    auto count = isize(glitches.size());
+    std::vector<Coord> unresolved;
+    for (const auto &it : glitches) {
+        if (!map.inpaint(it)) unresolved.push_back(it);
+    }
+    glitches = unresolved;
+
+    if (Options::flags.verbose) {
+
+        log::cout << log::vspace;
+        log::cout << log::ralign("Inpainted glitches: ");
+        log::cout << count - isize(glitches.size()) << log::endl;
+        log::cout << log::vspace;
+    }
+}
+
+template <bool periodcheck, bool attractorcheck, bool derivatives> void
 Driller::drill(const Coord &point, std::vector<Coord> &glitchPoints)
 {
     // If this point is the reference point, there is nothing to do
-    if (point == ref.coord) return;
+    if (point == ref.coord && ref.isCentered()) return;
 
     // The depth of the reference point limits how deep we can drill
-    isize limit = ref.xn.size();
+    isize limit = Options::location.depth;
+    isize available = await(ref.skipped);
 
     // Threshold value for detecting an escaping orbit
-    double escape = Options::location.escape * Options::location.escape;
+    double escape = std::pow(std::min(Options::location.bailout, Options::location.escape), 2);
 
     // Determine the iteration to start with
     isize iteration = ref.skipped;
 
     // Setup orbit parameters
-    ExtendedComplex d0 = map.distance(point, ref.coord);
+    ExtendedComplex d0 = delta(point);
     ExtendedComplex dn = d0;
 
     // Setup derivation parameters (df/dc)
@@ -412,6 +917,15 @@ Driller::drill(const Coord &point, std::vector<Coord> &glitchPoints)
     ExtendedComplex derz0 = ExtendedComplex(1.0, 0.0);
     ExtendedComplex derzn = derz0;
 
+    // Setup the position inside the stored orbit (which wraps around for
+    // periodic orbits, once the reference orbit is complete)
+    isize wrap = limit, period = 0;
+    auto sync = [&]() {
+        if (complete) { wrap = isize(ref.xn.size()); period = ref.period; }
+    };
+    sync();
+    isize k = period ? ref.index(iteration) : iteration;
+
     // Prepare for period checking
     ExtendedComplex p = dn;
     isize nextUpdate = iteration + 16;
@@ -421,8 +935,12 @@ Driller::drill(const Coord &point, std::vector<Coord> &glitchPoints)
 
         dn = approximator.evaluate(point, d0, iteration);
         dn.reduce();
-        dercn = approximator.evaluateDerivate(point, d0, iteration);
-        dercn.reduce();
+
+        if constexpr (derivatives) {
+
+            dercn = approximator.evaluateDerivate(point, d0, iteration);
+            dercn.reduce();
+        }
     }
 
     //
@@ -431,28 +949,42 @@ Driller::drill(const Coord &point, std::vector<Coord> &glitchPoints)
 
     while (++iteration < limit) {
 
-        auto two_xn_plus_dn = ref.xn[iteration - 1].extended2 + dn;
+        // Wait for the reference orbit if it is still under construction
+        if (iteration >= available) {
+            if ((available = await(iteration)) <= iteration) break;
+            sync();
+        }
+
+        auto two_xn_plus_dn = ref.xn[k].extended2 + dn;
         auto two_xn_plus_two_dn = two_xn_plus_dn + dn;
 
-        dercn *= two_xn_plus_two_dn;
-        dercn += derc0;
-        dercn.reduce();
+        if constexpr (derivatives) {
+
+            dercn *= two_xn_plus_two_dn;
+            dercn += derc0;
+            dercn.reduce();
+        }
+
+        if constexpr (attractorcheck) {
 
-        derzn *= two_xn_plus_two_dn;
-        derzn.reduce();
+            derzn *= two_xn_plus_two_dn;
+            derzn.reduce();
+        }
 
         dn *= two_xn_plus_dn;
         dn += d0;
         dn.reduce();
 
-        auto zn = ref.xn[iteration].extended + dn;
+        if (++k == wrap) k -= period;
+
+        auto zn = ref.xn[k].extended + dn;
         double norm = zn.norm().asDouble();
 
         //
         // Glitch check
         //
 
-        if (norm < ref.xn[iteration].tolerance) {
+        if (norm < ref.xn[k].tolerance) {
             break;
         }
 
@@ -460,7 +992,7 @@ Driller::drill(const Coord &point, std::vector<Coord> &glitchPoints)
         // Period check
         //
 
-        if (Options::periodcheck.enable) {
+        if constexpr (periodcheck) {
 
             if ((dn - p).norm().asDouble() < Options::periodcheck.tolerance) {
                 map.set(point, {
@@ -479,7 +1011,7 @@ Driller::drill(const Coord &point, std::vector<Coord> &glitchPoints)
         // Attractor check
         //
 
-        if (Options::attractorcheck.enable) {
+        if constexpr (attractorcheck) {
 
             if (derzn.norm().asDouble() < Options::attractorcheck.tolerance) {
                 map.set(point, {
@@ -496,17 +1028,23 @@ Driller::drill(const Coord &point, std::vector<Coord> &glitchPoints)
 
         if (norm >= escape) {
 
-            // Compute the normal vector
-            auto nv = zn / dercn;
-            nv.normalize();
+            if constexpr (derivatives) {
 
-            map.set(point, {
-                .result     = DR_ESCAPED,
-                .first      = (i32)ref.skipped,
-                .last       = (i32)iteration,
-                .zn         = StandardComplex(zn),
-                .derivative = StandardComplex(dercn),
-                .normal     = StandardComplex(nv) } );
+                map.set(point, {
+                    .result     = DR_ESCAPED,
+                    .first      = (i32)ref.skipped,
+                    .last       = (i32)iteration,
+                    .zn         = zn,
+                    .derivative = dercn } );
+
+            } else {
+
+                map.set(point, {
+                    .result     = DR_ESCAPED,
+                    .first      = (i32)ref.skipped,
+                    .last       = (i32)iteration,
+                    .zn         = zn } );
+            }
             return;
         }
     }
@@ -516,7 +1054,7 @@ Driller::drill(const Coord &point, std::vector<Coord> &glitchPoints)
     // point temporarily. Computation has to be repeated with a different
     // reference poin with a larger depth.
 
-    if (limit == Options::location.depth) {
+    if (await(limit) == Options::location.depth) {
 
         map.set(point, {
             .result     = DR_MAX_DEPTH_REACHED,
@@ -14,10 +14,16 @@
 #include "config.h"
 #include "Types.h"
 #include "Approximator.h"
+#include "Chrono.h"
 #include "Coord.h"
 #include "DrillMap.h"
 #include "ReferencePoint.h"
 
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <random>
+
 namespace dd {
 
 class Driller {
@@ -33,6 +39,25 @@ class Driller {
     // The current reference point
     ReferencePoint ref;
 
+    // Indicates if the reference orbit is computed in the background
+    bool streaming = false;
+
+    // Point in time when drilling has to be finished (0 = no time limit)
+    Time deadline;
+
+    // Generator for picking reference points (each driller uses the same sequence)
+    std::minstd_rand rng;
+
+    // Number of reference iterations that are ready to use
+    std::atomic<isize> frontier = 0;
+
+    // Indicates if the reference orbit has been computed completely
+    std::atomic<bool> complete = false;
+
+    // Synchronization primitives for waiting on the reference orbit
+    std::mutex frontierMutex;
+    std::condition_variable frontierCond;
+
     
     //
     // Series approximation parameters
@@ -43,15 +68,25 @@ class Driller {
     
     // The probe points
     std::vector<Coord> probePoints;
-    
-    
+
+
+    //
+    // Statistics
+    //
+
+public:
+
+    // Time spent in the delta loops
+    Time loopTime;
+
+
     //
     // Initialization
     //
 
 public:
 
-    Driller(DrillMap &map);
+    Driller(DrillMap &map, Time deadline = Time());
     
     
     //
@@ -59,7 +94,10 @@ public:
     //
                 
 public:
-    
+
+    // Drills a map with the driller matching its zoom level (used by all apps)
+    static Time run(DrillMap &map);
+
     // Computes the drill map (main entry point)
     void drill();
         
@@ -76,10 +114,32 @@ private:
     // Picks a reference point
     ReferencePoint pickReference(const std::vector<Coord> &glitches);
 
+    // Tries to locate the nucleus of a minibrot inside the drill area
+    std::optional<ReferencePoint> findNucleus();
+
+    // Returns the distance of a point from the reference point
+    ExtendedComplex delta(const Coord &point) const;
+
     // Picks a collection of probe points
     void pickProbePoints(std::vector<Coord> &probes);
 
 
+    //
+    // Synchronizing
+    //
+
+private:
+
+    // Indicates if the time budget has been used up
+    bool expired() const { return deadline.ticks && Time::now() > deadline; }
+
+    // Makes the first 'count' reference iterations available
+    void publish(isize count, bool done = false);
+
+    // Waits until the reference orbit has passed the specified iteration
+    isize await(isize iteration);
+
+
     //
     // Drilling points
     //
@@ -92,13 +152,27 @@ private:
     // Drills a collection of probe points
     isize drillProbePoints(std::vector<Coord> &probes);
 
-    // Drills a single probe point
-    isize drillProbePoint(Coord &probe);
-
     // Drills a collection of delta points
     void drill(const std::vector<Coord> &remaining, std::vector<Coord> &glitchPoints);
 
+    // Drills a coarse grid first and interpolates all smooth grid cells
+    void interpolate(const std::vector<Coord> &remaining, std::vector<Coord> &glitchPoints);
+
+
+    //
+    // Resolving glitches
+    //
+
+private:
+
+    // Checks if none of the glitches has an unresolved neighbor
+    bool isScattered(const std::vector<Coord> &glitches) const;
+
+    // Inpaints the remaining glitches in a final pass
+    void resolve(std::vector<Coord> &glitches);
+
     // Drills a single delta point
+    template <bool periodcheck, bool attractorcheck, bool derivatives>
     void drill(const Coord &point, std::vector<Coord> &glitchPoints);
 };
 
@@ -35,13 +35,14 @@ MapAnalyzer::analyze(const DrillMap &map)
 
                 auto inBorder = [&]() {
                     // return Options::distance.enable && map.distMap[i] < Options::distance.threshold();
-                    return map.distMap[i] < Options::distance.threshold();
+                    return !map.distMap.empty() && map.distMap[i] < Options::distance.threshold();
                 };
 
-                bool optspot = !!map.firstIterationMap[i];
-                optspots.approximations += !!map.firstIterationMap[i];
-                saved.approximations += map.firstIterationMap[i];
-                saved.total += map.firstIterationMap[i];
+                auto first = map.firstIterationMap.empty() ? 0 : map.firstIterationMap[i];
+                bool optspot = !!first;
+                optspots.approximations += !!first;
+                saved.approximations += first;
+                saved.total += first;
 
                 switch(map.resultMap[i]) {
 
@@ -38,10 +38,46 @@ ReferenceIteration::ReferenceIteration(PrecisionComplex z, PrecisionComplex dz,
     this->derivative = dz;
 }
 
+bool
+ReferenceIteration::matches(const ReferenceIteration &other) const
+{
+    auto delta = extended - other.extended;
+    delta.reduce();
+
+    if (delta.mantissa == StandardComplex(0, 0)) return true;
+    if (extended.mantissa == StandardComplex(0, 0)) return false;
+
+    auto error = delta / extended;
+    error.reduce();
+
+    return error.norm().asDouble() < 1e-30;
+}
+
 ReferencePoint::ReferencePoint(Coord c, const PrecisionComplex &pc)
 {
     this->coord = c;
     this->location = pc;
 }
 
+isize
+ReferencePoint::findPeriod(isize distance) const
+{
+    auto last = isize(xn.size()) - 1;
+
+    // The period must divide the distance of the repeating iterations
+    for (isize p = 1; p <= distance; p++) {
+
+        if (distance % p || last - 2 * p + 1 < 0) continue;
+
+        // Accept the period if a full cycle repeats
+        bool match = true;
+        for (isize k = 0; match && k < p; k++) {
+            match = xn[last - k].matches(xn[last - k - p]);
+        }
+        if (match) return p;
+    }
+
+    return 0;
+}
+
 }
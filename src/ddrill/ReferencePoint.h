@@ -43,6 +43,14 @@ struct ReferenceIteration {
     
     ReferenceIteration(PrecisionComplex z, double tolerance);
     ReferenceIteration(PrecisionComplex z, PrecisionComplex dz, double tolerance);
+
+
+    //
+    // Comparing
+    //
+
+    // Checks if both iterations agree up to double precision
+    bool matches(const ReferenceIteration &other) const;
 };
 
 struct ReferencePoint {
@@ -52,9 +60,16 @@ struct ReferencePoint {
     
     // The location of this point
     PrecisionComplex location;
+
+    // Offset between the center of pixel 'coord' and the location
+    ExtendedComplex offset;
     
     // The computed orbit
     std::vector<ReferenceIteration> xn;
+
+    // The period of the orbit or 0 if the orbit is not periodic. For periodic
+    // orbits, xn only contains the preperiod followed by a single period.
+    isize period = 0;
     
     // The first iteration where series approximation fails
     isize skipped = 0;
@@ -72,6 +87,19 @@ struct ReferencePoint {
     
     ReferencePoint() { }
     ReferencePoint(Coord c, const PrecisionComplex &pc); 
+
+    // Indicates if the reference point is located at the center of a pixel
+    bool isCentered() const { return offset == ExtendedComplex(); }
+
+    // Maps an iteration to the corresponding element of xn
+    isize index(isize n) const {
+        auto size = isize(xn.size());
+        return n < size ? n : size - period + (n - size) % period;
+    }
+
+    // Searches the smallest period that is consistent with a repetition of
+    // the last iteration after 'distance' iterations (0 = no period found)
+    isize findPeriod(isize distance) const;
 };
 
 }
@@ -10,39 +10,255 @@
 // -----------------------------------------------------------------------------
 
 #include "SlowDriller.h"
+#include "Logger.h"
 #include "ProgressIndicator.h"
 #include "Options.h"
 
+#include <thread>
+
 namespace dd {
 
+bool
+SlowDriller::isPrecise(const DrillMap &map)
+{
+    // Orbits reach a magnitude of 2 before they escape
+    auto magnitude = std::max(1.0, StandardComplex(map.center).abs());
+    return map.pixelDelta.asDouble() > 1e-12 * magnitude;
+}
+
 void
 SlowDriller::drill()
 {
     std::vector<Coord> remaining;
 
-    auto width = Options::drillmap.width;
-    auto height = Options::drillmap.height;
-
-    for (isize y = 0; y < height; y++) {
-        for (isize x = 0; x < width; x++) {
+    for (isize y = map.areaUL.y; y <= map.areaLR.y; y++) {
+        if (map.isMirrored(y)) continue;
+        for (isize x = map.areaUL.x; x <= map.areaLR.x; x++) {
             remaining.push_back(Coord(x,y));
         }
     }
 
+    // Drill coarse lattices first to get a complete map when time runs out
+    if (deadline.ticks) map.sortCoarseToFine(remaining);
+
     drill(remaining);
+
+    // Fill the pixels that couldn't be drilled in time
+    if (expired()) {
+
+        map.fill();
+        log::cout << log::vspace << "Deadline reached" << log::endl << log::endl;
+    }
+
+    // Fill the rows that have been skipped due to symmetry
+    map.mirror();
 }
 
 void
 SlowDriller::drill(const std::vector<Coord> &remaining)
 {
-    ProgressIndicator progress("Running the legacy driller", remaining.size());
+    /* If standard precision suffices, points are drilled in batches with
+     * plain doubles instead of extended doubles. The iterations of a batch
+     * are independent of each other, which enables the compiler to vectorize
+     * the inner loop. In this mode, the area check, the period check, and the
+     * attractor check are performed as in the perturbation driller.
+     */
+    bool fast = isPrecise(map);
+    using Kernel = void (SlowDriller::*)(const Coord *, isize);
+    static constexpr Kernel kernels[8] = {
+
+        &SlowDriller::drillBatch<false, false, false>, &SlowDriller::drillBatch<false, false, true>,
+        &SlowDriller::drillBatch<false, true, false>,  &SlowDriller::drillBatch<false, true, true>,
+        &SlowDriller::drillBatch<true, false, false>,  &SlowDriller::drillBatch<true, false, true>,
+        &SlowDriller::drillBatch<true, true, false>,   &SlowDriller::drillBatch<true, true, true>
+    };
+    auto batch = kernels[Options::periodcheck.enable << 2 |
+                         Options::attractorcheck.enable << 1 |
+                         Options::drillmap.derivatives];
+
+    ProgressIndicator progress(fast ? "Drilling in standard precision" :
+                               "Running the legacy driller", remaining.size());
 
-    for (unsigned int i = 0; i < remaining.size(); i++) {
+    // Distribute the points among multiple threads in chunks
+    auto numThreads = isize(std::max(1U, std::thread::hardware_concurrency()));
+    auto count = isize(remaining.size());
+    auto chunkSize = isize(64);
+    std::atomic<isize> next = 0;
+    auto start = Time::now();
 
-        drill(remaining[i]);
+    auto worker = [&]() {
+
+        while (!Options::stop && !expired()) {
+
+            auto first = next.fetch_add(chunkSize);
+            if (first >= count) break;
+            auto last = std::min(first + chunkSize, count);
+
+            if (fast) {
+                (this->*batch)(remaining.data() + first, last - first);
+            } else {
+                for (isize i = first; i < last; i++) drill(remaining[i]);
+            }
+            progress.step(last - first);
+        }
+    };
 
-        if (Options::stop) throw UserInterruptException();
-        progress.step(1);
+    {   std::vector<std::jthread> threads;
+        for (isize nr = 1; nr < numThreads; nr++) threads.push_back(std::jthread(worker));
+        worker();
+    }
+    loopTime += Time::now() - start;
+    if (Options::stop) throw UserInterruptException();
+
+    // Derive the remaining channels
+    map.derive();
+}
+
+template <bool periodcheck, bool attractorcheck, bool derivatives> void
+SlowDriller::drillBatch(const Coord *points, isize count)
+{
+    constexpr isize lanes = 8;
+
+    i64 limit = Options::location.depth;
+    double escape = std::pow(std::min(Options::location.bailout, Options::location.escape), 2);
+    double ptolerance = Options::periodcheck.tolerance;
+    double atolerance = Options::attractorcheck.tolerance;
+
+    auto center = StandardComplex(map.center);
+    auto delta = map.pixelDelta.asDouble();
+    auto origin = Coord(map.width / 2, map.height / 2);
+
+    for (isize first = 0; first < count; first += lanes) {
+
+        auto num = std::min(lanes, count - first);
+
+        double cr[lanes], ci[lanes], zr[lanes], zi[lanes];
+        double dr[lanes], di[lanes], ar[lanes], ai[lanes], pr[lanes], pi[lanes];
+        i64 result[lanes], last[lanes];
+
+        // Setup the lanes (unused lanes repeat the last point)
+        for (isize l = 0; l < lanes; l++) {
+
+            auto &p = points[first + std::min(l, num - 1)];
+            pr[l] = zr[l] = cr[l] = center.re + delta * (p.x - origin.x);
+            pi[l] = zi[l] = ci[l] = center.im + delta * (p.y - origin.y);
+            dr[l] = ar[l] = 1.0;
+            di[l] = ai[l] = 0.0;
+            result[l] = DR_UNPROCESSED;
+            last[l] = limit;
+
+            // Perform the area check (no iterations are recorded, as in the perturbation driller)
+            if (Options::areacheck.enable) {
+
+                auto r1 = cr[l] + 1.0, ii = ci[l] * ci[l], q0 = cr[l] - 0.25;
+                auto q = q0 * q0 + ii;
+
+                if (r1 * r1 + ii < 0.0625) {
+                    result[l] = DR_IN_CARDIOID;
+                    last[l] = 0;
+                } else if (q * (q + q0) < ii * 0.25) {
+                    result[l] = DR_IN_BULB;
+                    last[l] = 0;
+                }
+            }
+        }
+
+        // Iterate until all lanes have finished
+        i64 nextUpdate = 16;
+        for (i64 iteration = 1; iteration < limit; iteration++) {
+
+            i64 active = 0;
+            for (isize l = 0; l < lanes; l++) {
+
+                bool running = result[l] == DR_UNPROCESSED;
+
+                if constexpr (derivatives) {
+
+                    auto ndr = 2.0 * (zr[l] * dr[l] - zi[l] * di[l]) + 1.0;
+                    auto ndi = 2.0 * (zr[l] * di[l] + zi[l] * dr[l]);
+                    dr[l] = running ? ndr : dr[l];
+                    di[l] = running ? ndi : di[l];
+                }
+                if constexpr (attractorcheck) {
+
+                    auto nar = 2.0 * (zr[l] * ar[l] - zi[l] * ai[l]);
+                    auto nai = 2.0 * (zr[l] * ai[l] + zi[l] * ar[l]);
+                    ar[l] = running ? nar : ar[l];
+                    ai[l] = running ? nai : ai[l];
+                }
+
+                auto nzr = zr[l] * zr[l] - zi[l] * zi[l] + cr[l];
+                auto nzi = 2.0 * zr[l] * zi[l] + ci[l];
+                zr[l] = running ? nzr : zr[l];
+                zi[l] = running ? nzi : zi[l];
+
+                // Classify the point (later checks take precedence)
+                i64 r = DR_UNPROCESSED;
+                r = nzr * nzr + nzi * nzi >= escape ? DR_ESCAPED : r;
+                if constexpr (attractorcheck) {
+                    r = ar[l] * ar[l] + ai[l] * ai[l] < atolerance ? DR_ATTRACTED : r;
+                }
+                if constexpr (periodcheck) {
+                    auto pdr = nzr - pr[l], pdi = nzi - pi[l];
+                    r = pdr * pdr + pdi * pdi < ptolerance ? DR_PERIODIC : r;
+                }
+
+                last[l] = running && r != DR_UNPROCESSED ? iteration : last[l];
+                result[l] = running ? r : result[l];
+                active += result[l] == DR_UNPROCESSED;
+            }
+            if (!active) break;
+
+            if constexpr (periodcheck) {
+
+                if (iteration == nextUpdate) {
+
+                    for (isize l = 0; l < lanes; l++) { pr[l] = zr[l]; pi[l] = zi[l]; }
+                    nextUpdate = i64(nextUpdate * 1.5);
+                }
+            }
+        }
+
+        // Record the results
+        for (isize l = 0; l < num; l++) {
+
+            auto &p = points[first + l];
+
+            switch (result[l]) {
+
+                case DR_UNPROCESSED:
+
+                    // This point is inside the Mandelbrot set
+                    map.set(p, {
+                        .result     = DR_MAX_DEPTH_REACHED,
+                        .last       = (i32)limit } );
+                    break;
+
+                case DR_ESCAPED:
+
+                    if (!std::isfinite(dr[l]) || !std::isfinite(di[l])) {
+
+                        // The derivative has overflowed
+                        drill(p);
+
+                    } else {
+
+                        // This point is outside the Mandelbrot set
+                        map.set(p, {
+                            .result     = DR_ESCAPED,
+                            .last       = (i32)last[l],
+                            .zn         = StandardComplex(zr[l], zi[l]),
+                            .derivative = StandardComplex(dr[l], di[l]) } );
+                    }
+                    break;
+
+                default:
+
+                    map.set(p, {
+                        .result     = DrillResult(result[l]),
+                        .last       = (i32)last[l] } );
+            }
+        }
     }
 }
 
@@ -57,16 +273,19 @@ SlowDriller::drill(const Coord &point)
     auto dn = d0;
 
     isize limit = Options::location.depth;
-    double escape = Options::location.escape * Options::location.escape;
+    double escape = std::pow(std::min(Options::location.bailout, Options::location.escape), 2);
 
     isize iteration = 0;
 
     // Enter the main loop
     while (++iteration < limit) {
 
-        dn *= xn * 2.0;
-        dn += d0;
-        dn.reduce();
+        if (Options::drillmap.derivatives) {
+
+            dn *= xn * 2.0;
+            dn += d0;
+            dn.reduce();
+        }
 
         xn *= xn;
         xn += x0;
@@ -78,14 +297,11 @@ SlowDriller::drill(const Coord &point)
         if (norm >= escape) {
 
             // This point is outside the Mandelbrot set
-            auto u = xn / dn;
-            u.normalize();
-
             map.set(point, {
                 .result     = DR_ESCAPED,
                 .last       = (i32)iteration,
-                .derivative = StandardComplex(dn),
-                .normal     = StandardComplex(u) } );
+                .zn         = xn,
+                .derivative = dn } );
             return;
         }
     }
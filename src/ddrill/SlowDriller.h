@@ -13,6 +13,7 @@
 
 #include "config.h"
 #include "Types.h"
+#include "Chrono.h"
 #include "Coord.h"
 #include "DrillMap.h"
 
@@ -23,6 +24,14 @@ class SlowDriller {
     // The associated drill map
     DrillMap &map;
 
+    // Point in time when drilling has to be finished (0 = no time limit)
+    Time deadline;
+
+public:
+
+    // Time spent in the delta loops
+    Time loopTime;
+
     
     //
     // Initialization
@@ -30,7 +39,10 @@ class SlowDriller {
 
 public:
 
-    SlowDriller(DrillMap &m) : map(m) { }
+    SlowDriller(DrillMap &m, Time d = Time()) : map(m), deadline(d) { }
+
+    // Checks whether standard precision suffices to tell adjacent pixels apart
+    static bool isPrecise(const DrillMap &map);
 
 
     //
@@ -42,13 +54,20 @@ public:
     // Computes the drill map (main entry point)
     void drill();
 
-private:
-
     // Drills a collection of points
     void drill(const std::vector<Coord> &remaining);
 
+private:
+
+    // Indicates if the time budget has been used up
+    bool expired() const { return deadline.ticks && Time::now() > deadline; }
+
     // Drills a single of point
     void drill(const Coord &point);
+
+    // Drills a batch of points in parallel with standard precision
+    template <bool periodcheck, bool attractorcheck, bool derivatives>
+    void drillBatch(const Coord *points, isize count);
 };
 
 }
@@ -0,0 +1,154 @@
+// -----------------------------------------------------------------------------
+// This file is part of DeepDrill
+//
+// A Mandelbrot generator based on perturbation and series approximation
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v3
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#include "Tuner.h"
+#include "Driller.h"
+#include "Options.h"
+#include "Logger.h"
+#include "ProgressIndicator.h"
+
+namespace dd {
+
+void
+Tuner::tune()
+{
+    /* The pilot map covers the same area as the drill map with a reduced
+     * resolution. It is drilled with the user-provided setting first to
+     * establish a quality reference. Afterwards, the number of coefficients,
+     * the approximation tolerance, and the number of tolerated bad pixels are
+     * optimized one after another. A candidate is accepted if it is faster
+     * than the best setting so far and the fraction of deviating pixels stays
+     * within the configured bound. Tuning counts against the time budget.
+     * Once the budget is used up, the best setting found so far is taken.
+     */
+    static constexpr isize coefficients[] = { 3, 5, 8, 12, 16 };
+    static constexpr double tolerances[] = { 1e-12, 1e-9, 1e-6 };
+    static constexpr isize badpixels[] = { 1, 10 };
+
+    auto scale = Options::autotune.scale;
+    auto height = std::max(isize(MIN_MAP_HEIGHT), Options::drillmap.height / scale);
+    auto width = Options::drillmap.width * height / Options::drillmap.height;
+    width = std::clamp(width, isize(MIN_MAP_WIDTH), isize(MAX_MAP_WIDTH));
+
+    auto user = Setting {
+        Options::approximation.coefficients,
+        Options::approximation.tolerance,
+        Options::perturbation.badpixels };
+    auto best = user;
+
+    auto count = std::size(coefficients) + std::size(tolerances) + std::size(badpixels) + 1;
+    ProgressIndicator progress("Tuning parameters", count);
+
+    pilot.resize(width, height);
+    pilot.allocate();
+
+    // Drill the pilot map with the user-provided setting
+    auto bestTime = run(best);
+    resultMap = pilot.resultMap;
+    nitcntMap = pilot.nitcntMap;
+    progress.step();
+
+    auto consider = [&](const Setting &candidate) {
+
+        progress.step();
+
+        // Stop tuning once the time budget has been used up
+        if (expired()) return;
+
+        // Skip the setting that has been measured already
+        if (candidate.coefficients == best.coefficients &&
+            candidate.tolerance == best.tolerance &&
+            candidate.badpixels == best.badpixels) return;
+
+        // Pilot runs that have been cut short are discarded
+        auto time = run(candidate);
+        if (!expired() && time < bestTime && deviation() <= Options::autotune.tolerance) {
+
+            best = candidate;
+            bestTime = time;
+        }
+    };
+
+    for (auto c : coefficients) {
+        consider(Setting { c, best.tolerance, best.badpixels });
+    }
+    for (auto t : tolerances) {
+        consider(Setting { best.coefficients, t, best.badpixels });
+    }
+    for (auto b : badpixels) {
+        consider(Setting { best.coefficients, best.tolerance, b * user.badpixels });
+    }
+
+    progress.done();
+
+    apply(best);
+
+    if (Options::flags.verbose) {
+
+        log::cout << log::vspace;
+        log::cout << log::ralign("Pilot map size: ");
+        log::cout << width << " x " << height << log::endl;
+        log::cout << log::ralign("Coefficients: ");
+        log::cout << best.coefficients << log::endl;
+        log::cout << log::ralign("Approximation tolerance: ");
+        log::cout << best.tolerance << log::endl;
+        log::cout << log::ralign("Bad pixels: ");
+        log::cout << best.badpixels << log::endl;
+        log::cout << log::vspace;
+    }
+}
+
+Time
+Tuner::run(const Setting &setting)
+{
+    apply(setting);
+
+    // Start from scratch (each driller picks the same sequence of reference points)
+    pilot.resize(pilot.width, pilot.height);
+    pilot.allocate();
+
+    log::cout.mute();
+
+    auto start = Time::now();
+    try { Driller(pilot, deadline).drill(); } catch (...) { log::cout.unmute(); throw; }
+    auto elapsed = Time::now() - start;
+
+    log::cout.unmute();
+
+    return elapsed;
+}
+
+double
+Tuner::deviation() const
+{
+    isize count = 0;
+
+    for (usize i = 0; i < resultMap.size(); i++) {
+
+        if (pilot.resultMap[i] != resultMap[i]) {
+            count++;
+        } else if (resultMap[i] == DR_ESCAPED && std::abs(pilot.nitcntMap[i] - nitcntMap[i]) > 0.1) {
+            count++;
+        }
+    }
+
+    return double(count) / double(resultMap.size());
+}
+
+void
+Tuner::apply(const Setting &setting)
+{
+    Options::approximation.coefficients = setting.coefficients;
+    Options::approximation.tolerance = setting.tolerance;
+    Options::perturbation.badpixels = setting.badpixels;
+}
+
+}
@@ -0,0 +1,75 @@
+// -----------------------------------------------------------------------------
+// This file is part of DeepDrill
+//
+// A Mandelbrot generator based on perturbation and series approximation
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v3
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#pragma once
+
+#include "config.h"
+#include "Types.h"
+#include "Chrono.h"
+#include "DrillMap.h"
+
+namespace dd {
+
+class Tuner {
+
+    // A candidate setting
+    struct Setting {
+
+        isize coefficients;
+        double tolerance;
+        double badpixels;
+    };
+
+    // Point in time when drilling has to be finished (0 = no time limit)
+    Time deadline;
+
+    // Downscaled version of the drill map
+    DrillMap pilot;
+
+    // Results of the pilot run with the user-provided setting
+    std::vector<DrillResult> resultMap;
+    std::vector<float> nitcntMap;
+
+
+    //
+    // Initialization
+    //
+
+public:
+
+    Tuner(Time deadline = Time()) : deadline(deadline) { }
+
+
+    //
+    // Tuning
+    //
+
+public:
+
+    // Selects the fastest setting that meets the quality bound
+    void tune();
+
+private:
+
+    // Indicates if the time budget has been used up
+    bool expired() const { return deadline.ticks && Time::now() > deadline; }
+
+    // Drills the pilot map with a candidate setting
+    Time run(const Setting &setting);
+
+    // Returns the fraction of pixels that differ from the reference run
+    double deviation() const;
+
+    // Writes a setting into the option structs
+    void apply(const Setting &setting);
+};
+
+}
@@ -148,6 +148,8 @@ Maker::generateIniFile(isize nr, const mpf_class &zoom)
     writeAreacheckSection(os);
     writePeriodcheckSection(os);
     writeAttractorcheckSection(os);
+    writeInterpolationSection(os);
+    writeAutotuneSection(os);
 
     copy(temp, projectDir / AssetManager::iniFile(nr));
 }
@@ -288,6 +290,26 @@ Maker::writeAttractorcheckSection(std::ofstream &os)
     os << std::endl;
 }
 
+void
+Maker::writeInterpolationSection(std::ofstream &os)
+{
+    os << "[interpolation]" << std::endl;
+    os << "enable = " << Options::keys["interpolation.enable"] << std::endl;
+    os << "cellsize = " << Options::keys["interpolation.cellsize"] << std::endl;
+    os << "tolerance = " << Options::keys["interpolation.tolerance"] << std::endl;
+    os << std::endl;
+}
+
+void
+Maker::writeAutotuneSection(std::ofstream &os)
+{
+    os << "[autotune]" << std::endl;
+    os << "enable = " << Options::keys["autotune.enable"] << std::endl;
+    os << "scale = " << Options::keys["autotune.scale"] << std::endl;
+    os << "tolerance = " << Options::keys["autotune.tolerance"] << std::endl;
+    os << std::endl;
+}
+
 void
 Maker::generateMakefile()
 {
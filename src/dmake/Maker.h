@@ -59,6 +59,8 @@ private:
     void writeAreacheckSection(std::ofstream &os);
     void writePeriodcheckSection(std::ofstream &os);
     void writeAttractorcheckSection(std::ofstream &os);
+    void writeInterpolationSection(std::ofstream &os);
+    void writeAutotuneSection(std::ofstream &os);
 
     void writeHeader(std::ofstream &os);
     void writeDefinitions(std::ofstream &os);
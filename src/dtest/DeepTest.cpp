@@ -0,0 +1,334 @@
+// -----------------------------------------------------------------------------
+// This file is part of DeepDrill
+//
+// A Mandelbrot generator based on perturbation and series approximation
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v3
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#include "DeepTest.h"
+#include "Driller.h"
+#include "Exception.h"
+#include "Logger.h"
+
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+
+int main(int argc, char *argv[])
+{
+    return dd::DeepTest().main(argc, argv);
+}
+
+namespace dd {
+
+const char *
+DeepTest::optstring() const
+{
+    return ":va:";
+}
+
+const option *
+DeepTest::longopts() const
+{
+    static struct option long_options[] = {
+
+        { "verbose",  no_argument,       NULL, 'v' },
+        { "assets",   required_argument, NULL, 'a' },
+        { NULL,       0,                 NULL,  0  }
+    };
+
+    return long_options;
+}
+
+void
+DeepTest::syntax() const
+{
+    log::cout << "Usage: ";
+    log::cout << "deeptest [-v] [-a <path>] [<keyvalue>] [<location>]" << log::endl;
+    log::cout << log::endl;
+    log::cout << "       -v or --verbose   Run in verbose mode" << log::endl;
+    log::cout << "       -a or --assets    Optional path to asset files" << log::endl;
+}
+
+void
+DeepTest::run()
+{
+    // Allocate and save all channels
+    Options::drillmap.first = true;
+    Options::drillmap.nitcnt = true;
+    Options::drillmap.dist = true;
+    Options::drillmap.derivative = true;
+    Options::drillmap.normal = true;
+    Options::drillmap.derivatives = true;
+    Options::parse("mapfile.derivative", "yes");
+
+    // Drill the location if one is given and check the map files otherwise
+    if (Options::getInputs(Format::INI).empty()) {
+        testMapfiles();
+    } else {
+        testDriller();
+    }
+}
+
+void
+DeepTest::testDriller()
+{
+    DrillMap map;
+    map.resize();
+
+    if (!Options::flags.verbose) log::cout.mute();
+    try { Driller::run(map); } catch (...) { log::cout.unmute(); throw; }
+    if (!Options::flags.verbose) log::cout.unmute();
+
+    map.derive();
+
+    /* Without a reference, the map is only checked for plausibility. Deltas
+     * that are flushed to zero make all pixels follow the reference orbit,
+     * which results in a flat map. Derivatives that overflow doubles result
+     * in zero distances and invalid normals.
+     */
+    isize escaped = 0, invalid = 0;
+    float min = std::numeric_limits<float>::infinity();
+    float max = -std::numeric_limits<float>::infinity();
+
+    for (isize i = 0; i < map.width * map.height; i++) {
+
+        if (map.resultMap[i] != DR_ESCAPED) continue;
+
+        escaped++;
+        min = std::min(min, map.nitcntMap[i]);
+        max = std::max(max, map.nitcntMap[i]);
+
+        auto dist = map.distMap[i];
+        auto normal = std::hypot(map.normalReMap[i], map.normalImMap[i]);
+        if (!(dist > 0.0f && std::isfinite(dist) && std::abs(normal - 1.0f) < 1e-3f)) invalid++;
+    }
+
+    log::cout << log::ralign("Escaped pixels: ") << escaped << log::endl;
+    log::cout << log::ralign("Normalized iteration counts: ") << min << " - " << max << log::endl;
+    log::cout << log::ralign("Invalid distances or normals: ") << invalid << log::endl;
+
+    if (escaped == 0) throw Exception("No pixel has escaped");
+    if (!(max - min > 1.0)) throw Exception("The normalized iteration counts are flat");
+    if (invalid) throw Exception("Some distance estimates or normals are invalid");
+}
+
+void
+DeepTest::testMapfiles()
+{
+    for (auto steep : { false, true }) {
+
+        DrillMap map;
+        generate(map, steep);
+
+        /* Every combination of codecs is saved and loaded. Steep maps exceed
+         * the half-precision range and check the fallback to single precision.
+         */
+        for (auto compress : { "no", "yes" }) {
+        for (auto predict : { "no", "yes" }) {
+        for (auto shuffle : { "no", "yes" }) {
+        for (auto xorshuffle : { "no", "yes" }) {
+        for (auto tiled : { "no", "yes" }) {
+        for (auto precision : { "single", "half", "quantized" }) {
+
+            if (string(shuffle) == "no" && string(xorshuffle) == "yes") continue;
+
+            Options::parse("mapfile.compress", compress);
+            Options::parse("mapfile.predict", predict);
+            Options::parse("mapfile.shuffle", shuffle);
+            Options::parse("mapfile.xorshuffle", xorshuffle);
+            Options::parse("mapfile.tiled", tiled);
+            Options::parse("mapfile.precision", precision);
+
+            auto config =
+            string(steep ? "steep" : "flat") +
+            " compress=" + compress + " predict=" + predict +
+            " shuffle=" + shuffle + " xorshuffle=" + xorshuffle +
+            " tiled=" + tiled + " precision=" + precision;
+
+            roundTrip(map, config);
+        }}}}}}
+    }
+
+    log::cout << log::ralign("Checked configurations: ") << checks << log::endl;
+    log::cout << log::ralign("Failed configurations: ") << failures << log::endl;
+
+    if (failures) throw Exception("Map files don't reproduce the saved channels");
+}
+
+void
+DeepTest::generate(DrillMap &map, bool steep)
+{
+    // The width doesn't match the tile size to produce partial tiles
+    map.resize(600, 300);
+    map.allocate();
+
+    for (isize y = 0; y < map.height; y++) {
+        for (isize x = 0; x < map.width; x++) {
+
+            auto i = y * map.width + x;
+            bool escaped = (x / 37 + y / 23) % 5 != 0;
+
+            map.resultMap[i] = !escaped ? DR_MAX_DEPTH_REACHED : x < 40 && y < 30 ? DR_IN_CARDIOID : DR_ESCAPED;
+            map.firstIterationMap[i] = u32((7 * x + 3 * y) % 50);
+            map.lastIterationMap[i] = escaped ? u32(100000 + x + y % 17) : 200000;
+
+            // Steep tiles span more iterations than half-precision values resolve
+            auto slope = steep && y >= 256 ? 5.0 : 0.2;
+            map.nitcntMap[i] = float(100000.0 + slope * x + 0.1 * y + 0.3 * std::sin(0.1 * x));
+
+            // Steep distance estimates overflow the half-precision range
+            auto scale = steep ? 20.0 : 10.0;
+            map.distMap[i] = escaped ? float(std::exp(-8.0 + scale * x / map.width + std::sin(0.05 * y))) : 0.0f;
+
+            map.derivReMap[i] = float(1e5 * std::cos(0.01 * x));
+            map.derivImMap[i] = float(1e-3 * std::sin(0.02 * y));
+
+            auto angle = 0.013 * x * y;
+            map.normalReMap[i] = float(std::cos(angle));
+            map.normalImMap[i] = float(std::sin(angle));
+        }
+    }
+
+    map.computeStats();
+}
+
+void
+DeepTest::roundTrip(DrillMap &map, const string &config)
+{
+    auto path = (fs::temp_directory_path() / "deeptest.map").string();
+    bool passed = false;
+
+    log::cout.mute();
+
+    try {
+
+        map.save(path);
+
+        // Check the full map
+        DrillMap loaded;
+        loaded.load(path);
+        passed = compare(map, loaded, Coord(isize(0), isize(0)), Coord(map.width - 1, map.height - 1), config);
+
+        if (Options::mapfile.tiled) {
+
+            // Check a region which doesn't start at a tile boundary
+            auto ul = Coord(isize(300), isize(100));
+            auto lr = Coord(map.width - 1, isize(200));
+
+            DrillMap region;
+            region.load(path, 0, ul, lr);
+            passed &= compare(map, region, ul, lr, config + " region");
+
+            // Check the first mip level
+            DrillMap downsampled;
+            downsampled.downsample(map);
+            downsampled.computeStats();
+
+            DrillMap level;
+            level.load(path, 1);
+            passed &= compare(downsampled, level, Coord(isize(0), isize(0)), Coord(level.width - 1, level.height - 1), config + " level 1");
+        }
+
+    } catch (std::exception &e) {
+
+        report(config + ": " + e.what());
+    }
+
+    log::cout.unmute();
+    fs::remove(path);
+
+    checks++;
+    if (!passed) failures++;
+    if (passed && Options::flags.verbose) log::cout << config << ": Passed" << log::endl;
+}
+
+void
+DeepTest::report(const string &message)
+{
+    log::cout.unmute();
+    log::cout << message << log::endl;
+    log::cout.mute();
+}
+
+bool
+DeepTest::compare(const DrillMap &original, const DrillMap &loaded, const Coord &ul, const Coord &lr, const string &config)
+{
+    bool passed = true;
+
+    if (original.width != loaded.width || original.height != loaded.height) {
+
+        report(config + ": Map size differs");
+        return false;
+    }
+
+    auto check = [&](const char *name, auto &expected, auto &actual, auto tolerance) {
+
+        if (!passed) return;
+
+        for (isize y = ul.y; y <= lr.y; y++) {
+            for (isize x = ul.x; x <= lr.x; x++) {
+
+                auto i = y * original.width + x;
+                auto e = double(expected[i]);
+                auto a = double(actual[i]);
+
+                if (std::abs(a - e) <= tolerance(e) || (std::isnan(a) && std::isnan(e))) continue;
+
+                std::stringstream ss;
+                ss << config << ": " << name << " differs at (" << x << "," << y << "): ";
+                ss << std::setprecision(9) << "Expected " << e << ", got " << a;
+                report(ss.str());
+
+                passed = false;
+                return;
+            }
+        }
+    };
+
+    // Tolerance of the channels stored in the requested precision
+    auto precise = [&](ChannelID id) {
+
+        auto range = original.stats[id].max - original.stats[id].min;
+
+        return [id, range](double v) {
+
+            switch (Options::mapfile.precision) {
+
+                case FloatPrecision::Half:
+
+                    // Half-precision differences to the tile minimum (or single precision)
+                    return std::min(std::abs(v), id == CHANNEL_NITCNT ? 256.0 : 65504.0) * 0x1p-11 +
+                    std::abs(v) * 0x1p-23 + 0x1p-24;
+
+                case FloatPrecision::Quantized:
+
+                    // Half of the largest possible step size
+                    return range / 131070.0 + std::abs(v) * 0x1p-22;
+
+                default:
+                    return 0.0;
+            }
+        };
+    };
+    auto exact = [](double) { return 0.0; };
+    auto fixed = [](double) { return 0x1p-15 + 0x1p-20; };
+
+    check("Drill result", original.resultMap, loaded.resultMap, exact);
+    check("First iteration", original.firstIterationMap, loaded.firstIterationMap, exact);
+    check("Last iteration", original.lastIterationMap, loaded.lastIterationMap, exact);
+    check("Normalized iteration count", original.nitcntMap, loaded.nitcntMap, precise(CHANNEL_NITCNT));
+    check("Distance estimate", original.distMap, loaded.distMap, precise(CHANNEL_DIST));
+    check("Derivative (re)", original.derivReMap, loaded.derivReMap, exact);
+    check("Derivative (im)", original.derivImMap, loaded.derivImMap, exact);
+    check("Normal (re)", original.normalReMap, loaded.normalReMap, fixed);
+    check("Normal (im)", original.normalImMap, loaded.normalImMap, fixed);
+
+    return passed;
+}
+
+}
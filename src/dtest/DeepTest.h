@@ -0,0 +1,71 @@
+// -----------------------------------------------------------------------------
+// This file is part of DeepDrill
+//
+// A Mandelbrot generator based on perturbation and series approximation
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v3
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#pragma once
+
+#include "config.h"
+#include "Application.h"
+#include "DrillMap.h"
+
+namespace dd {
+
+class DeepTest : public Application {
+
+    // Number of checked configurations and detected mismatches
+    isize checks = 0;
+    isize failures = 0;
+
+
+    //
+    // Methods from Application
+    //
+
+public:
+
+    void run();
+
+private:
+
+    const char *appName() const { return "DeepTest"; }
+    const char *optstring() const;
+    const option *longopts() const;
+    bool isAcceptedInputFormat(Format format) const { return format == Format::INI; }
+    bool isAcceptedOutputFormat(Format format) const { return false; }
+
+    void syntax() const;
+    void initialize() { };
+    void checkArguments() { };
+
+
+    //
+    // Auxiliary methods
+    //
+
+    // Drills the location and checks the drill map for plausibility
+    void testDriller();
+
+    // Saves and loads a synthetic map with all combinations of mapfile options
+    void testMapfiles();
+
+    // Fills a map with synthetic drill results (steep maps exceed the half-precision range)
+    void generate(DrillMap &map, bool steep);
+
+    // Saves a map with the current mapfile options and compares the loaded map
+    void roundTrip(DrillMap &map, const string &config);
+
+    // Compares the portion ul ... lr of a loaded map with the original map
+    bool compare(const DrillMap &original, const DrillMap &loaded, const Coord &ul, const Coord &lr, const string &config);
+
+    // Prints a message while the output of the map functions is muted
+    void report(const string &message);
+};
+
+}
@@ -236,6 +236,7 @@ Zoomer::loadMapFile(isize nr)
     fs::path path = Options::files.inputs.front();
     fs::path file = path / AssetManager::mapFile(nr);
 
+    // Only the channels read by the shaders are decoded
     drillMap[slotNr(nr)].load(file);
 
     return true;
@@ -176,6 +176,10 @@ Application::parseArguments(int argc, char *argv[], const char *optstr, const op
                 Options::files.outputs.push_back(optarg);
                 break;
 
+            case 't':
+                Options::overrides.push_back("map.tile=" + string(optarg));
+                break;
+
             case ':':
                 throw SyntaxError("Missing argument for option '" +
                                   string(argv[optind - 1]) + "'");
@@ -15,15 +15,370 @@
 #include "Coord.h"
 #include "IO.h"
 #include "Logger.h"
+#include "Parser.h"
 #include "ProgressIndicator.h"
 #include "StandardComplex.h"
 
+#include <bit>
+#include <cfloat>
+#include <thread>
+
+#if defined(__F16C__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
 namespace dd {
 
+// Approximates the natural logarithm of a positive, normalized number
+static inline double fastLog(double x)
+{
+    // Split x into m * 2^e with m in [sqrt(1/2), sqrt(2))
+    auto bits = std::bit_cast<u64>(x);
+    auto e = double(i64(bits >> 52) - 1023);
+    auto m = std::bit_cast<double>((bits & 0x000FFFFFFFFFFFFF) | 0x3FF0000000000000);
+    auto big = m > M_SQRT2;
+    m = big ? m * 0.5 : m;
+    e = big ? e + 1.0 : e;
+
+    // Evaluate ln(m) = 2 atanh(s) with s = (m - 1) / (m + 1) and |s| < 0.172
+    auto s = (m - 1.0) / (m + 1.0), s2 = s * s;
+    auto p = 2.0 / 9.0;
+    p = p * s2 + 2.0 / 7.0;
+    p = p * s2 + 2.0 / 5.0;
+    p = p * s2 + 2.0 / 3.0;
+    p = p * s2 + 2.0;
+
+    return s * p + e * M_LN2;
+}
+
+// Splits a complex number into a pair of float mantissas and a binary exponent
+static inline void split(const ExtendedComplex &c, float &re, float &im, i32 &exp)
+{
+    auto max = std::max(std::abs(c.mantissa.re), std::abs(c.mantissa.im));
+    auto e = max > 0.0 && std::isfinite(max) ? std::ilogb(max) : 0;
+
+    re = float(std::scalbn(c.mantissa.re, -e));
+    im = float(std::scalbn(c.mantissa.im, -e));
+    exp = max > 0.0 ? i32(c.exponent + e) : 0;
+}
+
+// Returns the number of bytes occupied by a single sample (at most)
+static constexpr isize sampleSize(ChannelFormat fmt)
+{
+    switch (fmt) {
+
+        case FMT_I8:        return 1;
+        case FMT_I16:       return 2;
+        case FMT_I24:       return 3;
+        case FMT_I32:       return 4;
+        case FMT_FP16:      return 2;
+        case FMT_FLOAT:     return 4;
+        case FMT_DOUBLE:    return 8;
+        case FMT_PAETH:     return 4;
+        case FMT_RLE:       return 2;
+        case FMT_SHUFFLE:   return 0;
+        case FMT_HALF:      return 2;
+        case FMT_QUANT16:   return 2;
+    }
+    return 0;
+}
+
+// Splits the records of each row into byte planes
+static void shuffle(u8 *data, isize width, isize height, isize stride, bool delta)
+{
+    auto count = width * height;
+
+    // XOR each record with its predecessor
+    if (delta) {
+        for (isize i = count * stride - 1; i >= stride; i--) data[i] ^= data[i - stride];
+    }
+
+    std::vector<u8> row(width * stride);
+    for (isize y = 0; y < height; y++) {
+
+        auto p = data + y * width * stride;
+        std::memcpy(row.data(), p, row.size());
+
+        for (isize k = 0; k < stride; k++) {
+            for (isize x = 0; x < width; x++) p[k * width + x] = row[x * stride + k];
+        }
+    }
+}
+
+const u8 *
+RowReader::next(isize width, isize stride)
+{
+    auto p = is.consume(width * stride);
+    if (!shuffled) return p;
+
+    row.resize(width * stride);
+    prev.resize(stride);
+
+    // Gather the bytes of each record from the byte planes
+    for (isize k = 0; k < stride; k++) {
+        for (isize x = 0; x < width; x++) row[x * stride + k] = p[k * width + x];
+    }
+
+    // Revert the XOR with the preceding record
+    if (delta) {
+
+        for (isize k = 0; k < stride; k++) row[k] ^= prev[k];
+        for (isize i = stride; i < width * stride; i++) row[i] ^= row[i - stride];
+        std::memcpy(prev.data(), row.data() + (width - 1) * stride, stride);
+    }
+
+    return row.data();
+}
+
+// Predicts an integer sample from its left, upper, and upper-left neighbor
+static inline u32 paeth(const u32 *data, isize x, isize y, isize stride)
+{
+    auto i = y * stride + x;
+    i64 a = x ? data[i - 1] : 0;
+    i64 b = y ? data[i - stride] : 0;
+    i64 c = x && y ? data[i - stride - 1] : 0;
+
+    auto p = a + b - c;
+    auto pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+    return u32(pa <= pb && pa <= pc ? a : pb <= pc ? b : c);
+}
+
+// Converts a float into an IEEE 754 half-precision number (rounding to nearest even)
+static inline u16 toHalf(float value)
+{
+#ifdef __F16C__
+    return u16(_cvtss_sh(value, _MM_FROUND_TO_NEAREST_INT));
+#else
+    auto f = std::bit_cast<u32>(value);
+    auto sign = u16((f >> 16) & 0x8000);
+    f &= 0x7FFFFFFF;
+
+    // Overflows become infinity, NaNs stay NaNs
+    if (f >= (127 + 16) << 23) return sign | (f > 0x7F800000 ? 0x7E00 : 0x7C00);
+
+    // Subnormal results are rounded by adding a magic number
+    if (f < (127 - 14) << 23) {
+
+        constexpr u32 magic = (127 - 15 + 23 - 10 + 1) << 23;
+        return sign | u16(std::bit_cast<u32>(std::bit_cast<float>(f) + std::bit_cast<float>(magic)) - magic);
+    }
+
+    // Normal results are rebiased and rounded
+    f += (u32(15 - 127) << 23) + 0xFFF + ((f >> 13) & 1);
+    return sign | u16(f >> 13);
+#endif
+}
+
+// Converts an IEEE 754 half-precision number into a float
+static inline float fromHalf(u16 value)
+{
+#ifdef __F16C__
+    return _cvtsh_ss(value);
+#else
+    constexpr u32 exponent = 0x7C00 << 13;
+
+    u32 f = u32(value & 0x7FFF) << 13;
+    auto e = f & exponent;
+    f += (127 - 15) << 23;
+
+    if (e == exponent) {
+
+        // Infinity or NaN
+        f += (128 - 16) << 23;
+
+    } else if (e == 0) {
+
+        // Zero or subnormal number
+        f += 1 << 23;
+        f = std::bit_cast<u32>(std::bit_cast<float>(f) - std::bit_cast<float>(u32(113) << 23));
+    }
+
+    return std::bit_cast<float>(f | u32(value & 0x8000) << 16);
+#endif
+}
+
+// Converts a row of floats into half-precision numbers
+static void toHalf(u8 *dst, const float *src, isize count)
+{
+    isize i = 0;
+
+#ifdef __F16C__
+    for (; i + 8 <= count; i += 8) {
+
+        auto half = _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT);
+        _mm_storeu_si128((__m128i *)(dst + 2 * i), half);
+    }
+#endif
+
+    for (; i < count; i++) {
+
+        auto half = toHalf(src[i]);
+        std::memcpy(dst + 2 * i, &half, 2);
+    }
+}
+
+// Converts a row of half-precision numbers into floats
+static void fromHalf(float *dst, const u8 *src, isize count)
+{
+    isize i = 0;
+
+#ifdef __F16C__
+    for (; i + 8 <= count; i += 8) {
+        _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(_mm_loadu_si128((const __m128i *)(src + 2 * i))));
+    }
+#endif
+
+    for (; i < count; i++) {
+
+        u16 half; std::memcpy(&half, src + 2 * i, 2);
+        dst[i] = fromHalf(half);
+    }
+}
+
+// Maps a row of floats onto 16-bit codes (NaNs map to 0, other values are clamped)
+static void quantize(u8 *dst, const float *src, isize count, float offset, float scale)
+{
+    isize i = 0;
+
+#ifdef __AVX2__
+    auto vo = _mm256_set1_ps(offset);
+    auto vs = _mm256_set1_ps(scale);
+    auto lo = _mm256_setzero_ps();
+    auto hi = _mm256_set1_ps(65535.0f);
+
+    auto codes = [&](const float *p) {
+
+        auto x = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(p), vo), vs);
+        return _mm256_cvtps_epi32(_mm256_min_ps(_mm256_max_ps(x, lo), hi));
+    };
+
+    for (; i + 16 <= count; i += 16) {
+
+        // Packing operates on 128-bit lanes which need to be reordered afterwards
+        auto packed = _mm256_packus_epi32(codes(src + i), codes(src + i + 8));
+        _mm256_storeu_si256((__m256i *)(dst + 2 * i), _mm256_permute4x64_epi64(packed, 0xD8));
+    }
+#endif
+
+    for (; i < count; i++) {
+
+        auto x = (src[i] - offset) * scale;
+        auto code = x > 0 ? u16(std::nearbyint(std::min(x, 65535.0f))) : u16(0);
+        std::memcpy(dst + 2 * i, &code, 2);
+    }
+}
+
+// Maps a row of 16-bit codes back onto floats
+static void dequantize(float *dst, const u8 *src, isize count, float offset, float step)
+{
+    isize i = 0;
+
+#ifdef __AVX2__
+    auto vo = _mm256_set1_ps(offset);
+    auto vs = _mm256_set1_ps(step);
+
+    for (; i + 8 <= count; i += 8) {
+
+        auto codes = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)(src + 2 * i)));
+        _mm256_storeu_ps(dst + i, _mm256_add_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(codes), vs), vo));
+    }
+#endif
+
+    for (; i < count; i++) {
+
+        u16 code; std::memcpy(&code, src + 2 * i, 2);
+        dst[i] = offset + float(code) * step;
+    }
+}
+
+// Checks if the samples of a channel with element type T can be copied verbatim
+template <ChannelFormat fmt, typename T> static constexpr bool isNative()
+{
+    switch (fmt) {
+
+        case FMT_I8:
+        case FMT_I16:
+        case FMT_I32:       return (std::is_integral_v<T> || std::is_enum_v<T>) && isizeof(T) == sampleSize(fmt);
+        case FMT_FLOAT:     return std::is_same_v<T, float>;
+        case FMT_DOUBLE:    return std::is_same_v<T, double>;
+
+        default:
+            return false;
+    }
+}
+
+// Converts a channel value into a sample
+template <ChannelFormat fmt, typename T> static inline void encode(u8 *p, T raw)
+{
+    auto store = [&](auto value) { std::memcpy(p, &value, sizeof(value)); };
+
+    if constexpr (fmt == FMT_I8) store(i8(raw));
+    if constexpr (fmt == FMT_I16) store(i16(raw));
+    if constexpr (fmt == FMT_I32) store(i32(raw));
+    if constexpr (fmt == FMT_FLOAT) store(float(raw));
+    if constexpr (fmt == FMT_DOUBLE) store(double(raw));
+    if constexpr (fmt == FMT_FP16) store(i16(raw * T(INT16_MAX)));
+    if constexpr (fmt == FMT_I24) {
+
+        p[0] = u8(i32(raw) >> 16);
+        p[1] = u8(i32(raw) >> 8);
+        p[2] = u8(i32(raw));
+    }
+}
+
+// Converts a sample into a channel value
+template <ChannelFormat fmt, typename T> static inline T decode(const u8 *p)
+{
+    auto fetch = [&](auto value) { std::memcpy(&value, p, sizeof(value)); return value; };
+
+    if constexpr (fmt == FMT_I8) return T(fetch(i8()));
+    if constexpr (fmt == FMT_I16) return T(fetch(i16()));
+    if constexpr (fmt == FMT_I32) return T(fetch(i32()));
+    if constexpr (fmt == FMT_FLOAT) return T(fetch(float()));
+    if constexpr (fmt == FMT_DOUBLE) return T(fetch(double()));
+    if constexpr (fmt == FMT_FP16) return T(double(fetch(i16())) / double(INT16_MAX));
+    if constexpr (fmt == FMT_I24) return T(((i32)(i8)p[0] << 16) + (p[1] << 8) + p[2]);
+}
+
+void
+ChannelStats::reset()
+{
+    present = false;
+    min = std::numeric_limits<double>::infinity();
+    max = -std::numeric_limits<double>::infinity();
+}
+
+void
+ChannelStats::update(double value)
+{
+    update(value, value);
+}
+
+void
+ChannelStats::update(double minValue, double maxValue)
+{
+    if (minValue > maxValue) return;
+
+    if ((minValue != 0.0 || maxValue != 0.0) && !present.load(std::memory_order_relaxed)) {
+        present.store(true, std::memory_order_relaxed);
+    }
+
+    // Only write if the range grows to keep concurrent updates cheap
+    auto lo = min.load(std::memory_order_relaxed);
+    while (minValue < lo && !min.compare_exchange_weak(lo, minValue, std::memory_order_relaxed)) { }
+    auto hi = max.load(std::memory_order_relaxed);
+    while (maxValue > hi && !max.compare_exchange_weak(hi, maxValue, std::memory_order_relaxed)) { }
+}
+
 void
 DrillMap::resize()
 {
     resize(Options::drillmap.width, Options::drillmap.height);
+    allocate();
+
+    // Restrict drilling to a portion of the map if requested
+    areaUL = Options::drillmap.areaUL;
+    areaLR = Options::drillmap.areaLR;
 }
 
 void
@@ -42,17 +397,39 @@ DrillMap::resize(isize w, isize h)
     ul = translate(Coord());
     lr = translate(Coord(width - 1, height -1));
 
+    areaUL = Coord();
+    areaLR = Coord(width - 1, height - 1);
+
+    // Check if the map is mirror-symmetric to the real axis
+    mpf_class offset = center.im * 2.0 / mpfPixelDelta;
+    mirrorSum = -1;
+    if (abs(offset) < 2 * height) {
+
+        auto sum = 2 * (height / 2) - offset.get_d();
+        if (std::abs(sum - std::round(sum)) < 1e-6) mirrorSum = isize(std::round(sum));
+    }
+
+    location.real = Options::keys["location.real"];
+    location.imag = Options::keys["location.imag"];
+    location.zoom = Options::keys["location.zoom"];
+    location.depth = Options::location.depth;
+
+    auto release = [](auto &channel) { channel.clear(); channel.shrink_to_fit(); };
+
     resultMap.assign(width * height, DrillResult::DR_UNPROCESSED);
-    firstIterationMap.assign(width * height, 0);
     lastIterationMap.assign(width * height, 0);
-    overlayMap.assign(width * height, 0);
-    textureMap.assign(width * height, 0);
-    nitcntMap.assign(width * height, 0);
-    distMap.assign(width * height, 0);
-    derivReMap.assign(width * height, 0);
-    derivImMap.assign(width * height, 0);
-    normalReMap.assign(width * height, 0);
-    normalImMap.assign(width * height, 0);
+    release(firstIterationMap);
+    release(nitcntMap);
+    release(distMap);
+    release(derivReMap);
+    release(derivImMap);
+    release(normalReMap);
+    release(normalImMap);
+    release(rawMap);
+    pending = false;
+    for (auto &it : stats) it.reset();
+    directory.clear();
+    mapping = nullptr;
 
     assert(!hasIterations());
     assert(!hasNormalizedIterationCounts());
@@ -60,35 +437,92 @@ DrillMap::resize(isize w, isize h)
     assert(!hasNormals());
 }
 
+void
+DrillMap::downsample(const DrillMap &source)
+{
+    resize(source.width / 2, source.height / 2);
+
+    // Pick the samples such that the map center stays in place
+    auto ox = source.width / 2 - 2 * (width / 2);
+    auto oy = source.height / 2 - 2 * (height / 2);
+
+    auto copy = [&](auto &channel, const auto &other) {
+
+        if (other.empty()) return;
+
+        channel.resize(width * height);
+        for (isize y = 0; y < height; y++) {
+            for (isize x = 0; x < width; x++) {
+                channel[y * width + x] = other[(2 * y + oy) * source.width + 2 * x + ox];
+            }
+        }
+    };
+
+    copy(resultMap, source.resultMap);
+    copy(firstIterationMap, source.firstIterationMap);
+    copy(lastIterationMap, source.lastIterationMap);
+    copy(nitcntMap, source.nitcntMap);
+    copy(distMap, source.distMap);
+    copy(derivReMap, source.derivReMap);
+    copy(derivImMap, source.derivImMap);
+    copy(normalReMap, source.normalReMap);
+    copy(normalImMap, source.normalImMap);
+}
+
+bool
+DrillMap::hasNextLevel(isize w, isize h)
+{
+    // Odd heights are excluded, because they would alter the pixel delta
+    return w / 2 >= MIN_MAP_WIDTH && h / 2 >= MIN_MAP_HEIGHT && h % 2 == 0;
+}
+
+void
+DrillMap::allocate()
+{
+    auto size = width * height;
+
+    if (Options::drillmap.first) firstIterationMap.assign(size, 0);
+    if (Options::drillmap.nitcnt) nitcntMap.assign(size, 0);
+    if (Options::drillmap.dist) distMap.assign(size, 0);
+    if (Options::drillmap.derivative) derivReMap.assign(size, 0);
+    if (Options::drillmap.derivative) derivImMap.assign(size, 0);
+    if (Options::drillmap.normal) normalReMap.assign(size, 0);
+    if (Options::drillmap.normal) normalImMap.assign(size, 0);
+    rawMap.assign(size, RawEntry { });
+}
+
 void
 DrillMap::set(isize w, isize h, const MapEntry &entry)
 {
     assert(w < width && h < height);
+    assert(!rawMap.empty());
 
     auto i = h * width + w;
-    auto derivative = StandardComplex(entry.derivative);
-    auto normal = StandardComplex(entry.normal);
 
     resultMap[i] = entry.result;
-    firstIterationMap[i] = entry.first;
     lastIterationMap[i] = entry.last;
-    derivReMap[i] = derivative.re;
-    derivImMap[i] = derivative.im;
-    normalReMap[i] = normal.re;
-    normalImMap[i] = normal.im;
+    if (!firstIterationMap.empty()) firstIterationMap[i] = entry.first;
+
+    stats[CHANNEL_RESULT].update(entry.result);
+    if (entry.result != DR_ESCAPED) stats[CHANNEL_LAST].update(entry.last);
+    if (!firstIterationMap.empty()) stats[CHANNEL_FIRST].update(entry.first);
+    if (!nitcntMap.empty()) nitcntMap[i] = 0;
+    if (!distMap.empty()) distMap[i] = 0;
+    if (!derivReMap.empty()) derivReMap[i] = derivImMap[i] = 0;
+    if (!normalReMap.empty()) normalReMap[i] = normalImMap[i] = 0;
 
-    auto znabs = entry.zn.abs();
+    // Record the final orbit state to derive the remaining channels later
+    if (entry.result == DR_ESCAPED) {
 
-    // Derive the normalized iteration count
-    auto znlog = znabs.log() / std::log(Options::location.escape);
-    auto znloglog = znlog.log() / std::log(2.0);
-    nitcntMap[i] = lastIterationMap[i] - znloglog.asDouble();
+        auto &raw = rawMap[i];
+        split(entry.zn, raw.znRe, raw.znIm, raw.znExp);
+        split(entry.derivative, raw.dnRe, raw.dnIm, raw.dnExp);
+        pending = true;
 
-    // Estimate the distance to the Mandelbrot set in pixels
-    auto znabslog = znabs.log().asDouble();
-    auto dist = znabs * 2.0 * znabslog / entry.derivative.abs();
-    dist /= pixelDelta;
-    distMap[i] = dist.asFloat();
+    } else {
+
+        rawMap[i] = RawEntry { };
+    }
 
     // Declare all textures as being outdated
     dirty = true;
@@ -100,6 +534,141 @@ DrillMap::set(const struct Coord &c, const MapEntry &entry)
     set(c.x, c.y, entry);
 }
 
+void
+DrillMap::derive()
+{
+    if (!pending.exchange(false)) return;
+    assert(!rawMap.empty());
+
+    auto logEscape = std::log(Options::location.escape);
+
+    // The pixel delta underflows doubles beyond a zoom factor of about 1e308
+    auto invDelta = ExtendedDouble(1.0 / pixelDelta.mantissa, -pixelDelta.exponent);
+
+    // Distribute the rows among multiple threads
+    auto numThreads = isize(std::max(1U, std::thread::hardware_concurrency()));
+    std::atomic<isize> next = 0;
+
+    auto worker = [&]() {
+        for (isize y = next++; y < height; y = next++) derive(y, logEscape, invDelta);
+    };
+
+    {   std::vector<std::jthread> threads;
+        for (isize nr = 1; nr < numThreads; nr++) threads.push_back(std::jthread(worker));
+        worker();
+    }
+
+    // Declare all textures as being outdated
+    dirty = true;
+}
+
+void
+DrillMap::derive(isize y, double logEscape, const ExtendedDouble &invDelta)
+{
+    /* Orbits are stopped once they exceed the bailout radius which is usually
+     * much smaller than the escape radius. Beyond the bailout radius, z^2
+     * dominates c and the remaining iterations could be carried out by
+     * z -> z^2 and dz -> 2 z dz. These iterations preserve the normalized
+     * iteration count, the distance estimate, and the direction of the normal
+     * vector. Hence, these channels are computed from the values at the
+     * bailout radius in a first loop which is free of branches. Only the
+     * iteration count and the derivative are continued to the escape radius
+     * in a second loop.
+     */
+    constexpr auto inf = std::numeric_limits<double>::infinity();
+
+    auto logLogEscape = std::log(logEscape);
+    auto row = y * width;
+
+    // Value ranges of this row
+    double nitcntMin = inf, nitcntMax = -inf;
+    double distMin = inf, distMax = -inf;
+    double normalMin = inf, normalMax = -inf;
+    double derivMin = inf, derivMax = -inf;
+    double lastMin = inf, lastMax = -inf;
+
+    for (isize i = row; i < row + width; i++) {
+
+        auto &raw = rawMap[i];
+        bool derive = raw.znRe != 0.0f || raw.znIm != 0.0f;
+
+        auto zre = double(raw.znRe), zim = double(raw.znIm);
+        auto dre = double(raw.dnRe), dim = double(raw.dnIm);
+        auto zabs = std::sqrt(zre * zre + zim * zim);
+        auto dabs = std::sqrt(dre * dre + dim * dim);
+
+        // Derive the normalized iteration count
+        auto zlog = fastLog(derive ? zabs : 1.0) + raw.znExp * M_LN2;
+        auto nitcnt = lastIterationMap[i] - (fastLog(derive ? zlog : 1.0) - logLogEscape) / M_LN2;
+
+        // Compute the normal vector (the direction of zn / dn)
+        auto nre = zre * dre + zim * dim;
+        auto nim = zim * dre - zre * dim;
+        auto nscale = dabs > 0.0 ? 1.0 / std::sqrt(nre * nre + nim * nim) : 0.0;
+        nre *= nscale;
+        nim *= nscale;
+
+        nitcntMin = std::min(nitcntMin, derive ? nitcnt : inf);
+        nitcntMax = std::max(nitcntMax, derive ? nitcnt : -inf);
+        normalMin = std::min(normalMin, derive ? std::min(nre, nim) : inf);
+        normalMax = std::max(normalMax, derive ? std::max(nre, nim) : -inf);
+
+        if (!nitcntMap.empty()) nitcntMap[i] = derive ? float(nitcnt) : nitcntMap[i];
+        if (!normalReMap.empty()) normalReMap[i] = derive ? float(nre) : normalReMap[i];
+        if (!normalImMap.empty()) normalImMap[i] = derive ? float(nim) : normalImMap[i];
+
+        // Estimate the distance to the Mandelbrot set in pixels
+        if (!distMap.empty() && derive) {
+
+            auto dist = zabs * 2.0 * zlog / dabs * invDelta.mantissa;
+            distMap[i] = float(std::ldexp(dist, int(raw.znExp - raw.dnExp + invDelta.exponent)));
+            distMin = std::min(distMin, double(distMap[i]));
+            distMax = std::max(distMax, double(distMap[i]));
+        }
+    }
+
+    for (isize i = row; i < row + width; i++) {
+
+        auto &raw = rawMap[i];
+        if (raw.znRe == 0.0f && raw.znIm == 0.0f) continue;
+
+        // Continue the orbit up to the escape radius
+        auto zlog = std::log(std::hypot(double(raw.znRe), double(raw.znIm))) + raw.znExp * M_LN2;
+        isize steps = 0;
+        for (; zlog > 0.0 && zlog < logEscape; zlog *= 2.0) steps++;
+        lastIterationMap[i] += u32(steps);
+        lastMin = std::min(lastMin, double(lastIterationMap[i]));
+        lastMax = std::max(lastMax, double(lastIterationMap[i]));
+
+        if (!derivReMap.empty()) {
+
+            auto z = StandardComplex(std::scalbn(double(raw.znRe), raw.znExp),
+                                     std::scalbn(double(raw.znIm), raw.znExp));
+            auto dz = StandardComplex(std::scalbn(double(raw.dnRe), raw.dnExp),
+                                      std::scalbn(double(raw.dnIm), raw.dnExp));
+
+            for (isize k = 0; k < steps; k++) {
+
+                dz = StandardComplex(2.0 * (z.re * dz.re - z.im * dz.im),
+                                     2.0 * (z.re * dz.im + z.im * dz.re));
+                z = StandardComplex(z.re * z.re - z.im * z.im, 2.0 * z.re * z.im);
+            }
+            derivReMap[i] = float(dz.re);
+            derivImMap[i] = float(dz.im);
+            derivMin = std::min({ derivMin, double(derivReMap[i]), double(derivImMap[i]) });
+            derivMax = std::max({ derivMax, double(derivReMap[i]), double(derivImMap[i]) });
+        }
+        raw = RawEntry { };
+    }
+
+    // Update the channel statistics
+    stats[CHANNEL_LAST].update(lastMin, lastMax);
+    if (!nitcntMap.empty()) stats[CHANNEL_NITCNT].update(nitcntMin, nitcntMax);
+    if (!distMap.empty()) stats[CHANNEL_DIST].update(distMin, distMax);
+    if (!derivReMap.empty()) stats[CHANNEL_DERIVATIVE].update(derivMin, derivMax);
+    if (!normalReMap.empty()) stats[CHANNEL_NORMAL].update(normalMin, normalMax);
+}
+
 PrecisionComplex
 DrillMap::translate(const Coord &coord) const
 {
@@ -120,7 +689,7 @@ DrillMap::translate(const PrecisionComplex &coord) const
     // Compute the distance to the center
     auto dxy = coord -  center;
     mpf_class dx = dxy.re / mpfPixelDelta;
-    mpf_class dy = dxy.re / mpfPixelDelta;
+    mpf_class dy = dxy.im / mpfPixelDelta;
 
     return c + Coord(dx.get_si(), dy.get_si());
 }
@@ -151,81 +720,458 @@ DrillMap::distance(const Coord &coord) const
 void
 DrillMap::getMesh(isize numx, isize numy, std::vector<Coord> &mesh) const
 {
-    // The coordinate system is superimposed with an equidistant mesh.
+    // The drill area is superimposed with an equidistant mesh.
     // The density of the mesh is controlled by the 'numx' and 'numy'.
     // The minimum value is 2 which produces a mesh that comprises the four
     // corner points.
 
     mesh.clear();
 
+    auto w = areaLR.x - areaUL.x;
+    auto h = areaLR.y - areaUL.y;
+
     for (isize i = 0; i < numx; i++) {
         for (isize j = 0; j < numy; j++) {
 
-            auto x = (width - 1) * ((double)i / (double)(numx - 1));
-            auto y = (height - 1) * ((double)j / (double)(numy - 1));
+            auto x = areaUL.x + w * ((double)i / (double)(numx - 1));
+            auto y = areaUL.y + h * ((double)j / (double)(numy - 1));
 
             mesh.push_back(Coord(x,y));
         }
     }
 }
 
+void
+DrillMap::sortCoarseToFine(std::vector<Coord> &coords) const
+{
+    /* Each pixel is assigned to the coarsest lattice it belongs to. The
+     * coarsest lattice comprises every 16th pixel in both directions, the
+     * finest lattice comprises all pixels.
+     */
+    auto level = [&](const Coord &c) {
+
+        auto dx = isize(c.x - areaUL.x) | 16;
+        auto dy = isize(c.y - areaUL.y) | 16;
+        return std::countr_zero(u64(dx | dy));
+    };
+
+    std::stable_sort(coords.begin(), coords.end(), [&](const Coord &a, const Coord &b) {
+        return level(a) > level(b);
+    });
+}
+
+isize
+DrillMap::mirrorRow(isize y) const
+{
+    if (mirrorSum < 0) return -1;
+
+    auto result = mirrorSum - y;
+    return result >= 0 && result < height ? result : -1;
+}
+
+bool
+DrillMap::isMirrored(isize y) const
+{
+    auto m = mirrorRow(y);
+    return m >= areaUL.y && m < y;
+}
+
+void
+DrillMap::mirror()
+{
+    derive();
+
+    auto copy = [](auto &channel, isize to, isize from) {
+        if (!channel.empty()) channel[to] = channel[from];
+    };
+    auto negate = [](auto &channel, isize to, isize from) {
+        if (!channel.empty()) channel[to] = -channel[from];
+    };
+
+    bool mirrored = false;
+
+    for (isize y = areaUL.y; y <= areaLR.y; y++) {
+
+        if (!isMirrored(y)) continue;
+        mirrored = true;
+
+        auto from = mirrorRow(y) * width;
+        auto to = y * width;
+
+        for (isize x = areaUL.x; x <= areaLR.x; x++) {
+
+            resultMap[to + x] = resultMap[from + x];
+            lastIterationMap[to + x] = lastIterationMap[from + x];
+        }
+        for (isize x = areaUL.x; x <= areaLR.x; x++) {
+
+            copy(firstIterationMap, to + x, from + x);
+            copy(nitcntMap, to + x, from + x);
+            copy(distMap, to + x, from + x);
+            copy(derivReMap, to + x, from + x);
+            negate(derivImMap, to + x, from + x);
+            copy(normalReMap, to + x, from + x);
+            negate(normalImMap, to + x, from + x);
+        }
+    }
+
+    // Negating the imaginary parts may extend the value ranges
+    if (mirrored) {
+        for (auto id : { CHANNEL_DERIVATIVE, CHANNEL_NORMAL }) {
+            stats[id].update(-stats[id].max, -stats[id].min);
+        }
+    }
+
+    // Declare all textures as being outdated
+    dirty = true;
+}
+
+void
+DrillMap::interpolate(const Coord &ul, const Coord &lr)
+{
+    auto i00 = ul.y * width + ul.x, i01 = ul.y * width + lr.x;
+    auto i10 = lr.y * width + ul.x, i11 = lr.y * width + lr.x;
+    auto w = double(lr.x - ul.x), h = double(lr.y - ul.y);
+
+    for (isize y = ul.y; y <= lr.y; y++) {
+
+        auto ty = (y - ul.y) / h;
+
+        for (isize x = ul.x; x <= lr.x; x++) {
+
+            auto i = y * width + x;
+            if (resultMap[i] != DR_UNPROCESSED) continue;
+
+            auto tx = (x - ul.x) / w;
+
+            // Blends the four corner values of a channel
+            auto lerp = [&](const auto &channel) {
+                if (channel.empty()) return 0.0;
+                auto top = (1 - tx) * double(channel[i00]) + tx * double(channel[i01]);
+                auto bot = (1 - tx) * double(channel[i10]) + tx * double(channel[i11]);
+                return (1 - ty) * top + ty * bot;
+            };
+
+            auto nitcnt = lerp(nitcntMap);
+            auto normal = StandardComplex(lerp(normalReMap), lerp(normalImMap));
+            if (auto len = normal.abs(); len > 0) normal *= 1.0 / len;
+
+            resultMap[i] = DR_ESCAPED;
+            lastIterationMap[i] = u32(std::ceil(nitcnt));
+            if (!firstIterationMap.empty()) firstIterationMap[i] = u32(lerp(firstIterationMap));
+            if (!nitcntMap.empty()) nitcntMap[i] = float(nitcnt);
+            if (!distMap.empty()) distMap[i] = float(lerp(distMap));
+            if (!derivReMap.empty()) derivReMap[i] = float(lerp(derivReMap));
+            if (!derivImMap.empty()) derivImMap[i] = float(lerp(derivImMap));
+            if (!normalReMap.empty()) normalReMap[i] = float(normal.re);
+            if (!normalImMap.empty()) normalImMap[i] = float(normal.im);
+            updateStats(i);
+        }
+    }
+
+    // Declare all textures as being outdated
+    dirty = true;
+}
+
+void
+DrillMap::fill()
+{
+    derive();
+
+    auto copy = [](auto &channel, isize to, isize from) {
+        if (!channel.empty()) channel[to] = channel[from];
+    };
+
+    for (isize y = areaUL.y; y <= areaLR.y; y++) {
+
+        if (isMirrored(y)) continue;
+
+        for (isize x = areaUL.x; x <= areaLR.x; x++) {
+
+            auto to = y * width + x;
+            if (resultMap[to] != DR_UNPROCESSED && resultMap[to] != DR_GLITCH) continue;
+
+            // Search the finest lattice containing a resolved pixel
+            for (isize s = 2; s <= 16; s *= 2) {
+
+                auto sx = areaUL.x + (x - areaUL.x) / s * s;
+                auto sy = areaUL.y + (y - areaUL.y) / s * s;
+                auto from = sy * width + sx;
+
+                if (resultMap[from] == DR_UNPROCESSED || resultMap[from] == DR_GLITCH) continue;
+
+                resultMap[to] = resultMap[from];
+                lastIterationMap[to] = lastIterationMap[from];
+                copy(firstIterationMap, to, from);
+                copy(nitcntMap, to, from);
+                copy(distMap, to, from);
+                copy(derivReMap, to, from);
+                copy(derivImMap, to, from);
+                copy(normalReMap, to, from);
+                copy(normalImMap, to, from);
+                updateStats(to);
+                break;
+            }
+        }
+    }
+
+    // Declare all textures as being outdated
+    dirty = true;
+}
+
 bool
-DrillMap::hasDrillResults() const
+DrillMap::inpaint(const Coord &c, isize minNeighbors)
 {
-    for (isize i = 0; i < width * height; i++) {
-        if (resultMap[i]) return true;
+    auto resolved = [&](isize i) {
+        return resultMap[i] != DR_UNPROCESSED && resultMap[i] != DR_GLITCH;
+    };
+
+    // Collect all resolved neighbors inside the drill area
+    std::vector<isize> neighbors;
+    for (isize y = c.y - 1; y <= c.y + 1; y++) {
+
+        if (y < areaUL.y || y > areaLR.y || isMirrored(y)) continue;
+
+        for (isize x = c.x - 1; x <= c.x + 1; x++) {
+
+            if (x < areaUL.x || x > areaLR.x) continue;
+            if (auto i = y * width + x; resolved(i)) neighbors.push_back(i);
+        }
     }
-    return false;
+    if (isize(neighbors.size()) < minNeighbors) return false;
+
+    // Adopt the most frequent drill result
+    auto count = [&](DrillResult r) {
+        return std::count_if(neighbors.begin(), neighbors.end(), [&](isize i) { return resultMap[i] == r; });
+    };
+    auto result = resultMap[*std::max_element(neighbors.begin(), neighbors.end(), [&](isize a, isize b) {
+        return count(resultMap[a]) < count(resultMap[b]);
+    })];
+    std::erase_if(neighbors, [&](isize i) { return resultMap[i] != result; });
+
+    // Average the channels of all neighbors with the same result
+    auto mean = [&](const auto &channel) {
+        if (channel.empty()) return 0.0;
+        double sum = 0.0;
+        for (auto i : neighbors) sum += double(channel[i]);
+        return sum / double(neighbors.size());
+    };
+
+    auto i = c.y * width + c.x;
+    auto normal = StandardComplex(mean(normalReMap), mean(normalImMap));
+    if (auto len = normal.abs(); len > 0) normal *= 1.0 / len;
+
+    resultMap[i] = result;
+    lastIterationMap[i] = u32(std::round(mean(lastIterationMap)));
+    if (!firstIterationMap.empty()) firstIterationMap[i] = u32(std::round(mean(firstIterationMap)));
+    if (!nitcntMap.empty()) nitcntMap[i] = float(mean(nitcntMap));
+    if (!distMap.empty()) distMap[i] = float(mean(distMap));
+    if (!derivReMap.empty()) derivReMap[i] = float(mean(derivReMap));
+    if (!derivImMap.empty()) derivImMap[i] = float(mean(derivImMap));
+    if (!normalReMap.empty()) normalReMap[i] = float(normal.re);
+    if (!normalImMap.empty()) normalImMap[i] = float(normal.im);
+    updateStats(i);
+
+    // Declare all textures as being outdated
+    dirty = true;
+
+    return true;
 }
 
 bool
-DrillMap::hasIterations() const
+DrillMap::isShard() const
+{
+    return !(areaUL == Coord() && areaLR == Coord(width - 1, height - 1));
+}
+
+void
+DrillMap::merge(const DrillMap &other)
 {
-    for (isize i = 0; i < width * height; i++) {
-        if (lastIterationMap[i]) return true;
+    // Make sure that both maps belong to the same image
+    if (other.width != width || other.height != height) {
+        throw Exception("Map sizes don't match (" +
+                        std::to_string(width) + " x " + std::to_string(height) + " vs. " +
+                        std::to_string(other.width) + " x " + std::to_string(other.height) + ")");
     }
-    return false;
+    auto same = [](const string &lhs, const string &rhs) {
+
+        // Compare numerically, because the same value may be written differently
+        mpf_class a, b;
+        Parser::parse(lhs, a);
+        Parser::parse(rhs, b);
+        return a == b;
+    };
+    if (!same(other.location.real, location.real) ||
+        !same(other.location.imag, location.imag) ||
+        !same(other.location.zoom, location.zoom)) {
+        throw Exception("Map files have been drilled at different locations");
+    }
+    if (other.location.depth != location.depth) {
+        throw Exception("Map files have been drilled with different depths");
+    }
+
+    // Make sure that both maps provide the same channels
+    auto channels = [](const DrillMap &map) {
+
+        u8 result = 0;
+        for (auto &entry : map.directory) result |= u8(1 << entry.id);
+        return result;
+    };
+    if (channels(other) != channels(*this)) {
+        throw Exception("Map files contain different channels");
+    }
+
+    // Make sure that the drill areas don't overlap
+    if (other.areaUL.x <= areaLR.x && other.areaLR.x >= areaUL.x &&
+        other.areaUL.y <= areaLR.y && other.areaLR.y >= areaUL.y) {
+        throw Exception("Map files have overlapping drill areas (" +
+                        std::to_string(areaUL.x) + "," + std::to_string(areaUL.y) + " - " +
+                        std::to_string(areaLR.x) + "," + std::to_string(areaLR.y) + " vs. " +
+                        std::to_string(other.areaUL.x) + "," + std::to_string(other.areaUL.y) + " - " +
+                        std::to_string(other.areaLR.x) + "," + std::to_string(other.areaLR.y) + ")");
+    }
+
+    // Copy all channels inside the drill area of the other map
+    auto copy = [&](auto &to, const auto &from, isize offset, isize count) {
+        if (to.empty() && from.empty()) return;
+        if (to.empty() || from.empty()) throw Exception("Map files contain different channels");
+        std::copy(from.begin() + offset, from.begin() + offset + count, to.begin() + offset);
+    };
+
+    for (isize y = other.areaUL.y; y <= other.areaLR.y; y++) {
+
+        auto offset = y * width + other.areaUL.x;
+        auto count = other.areaLR.x - other.areaUL.x + 1;
+
+        copy(resultMap, other.resultMap, offset, count);
+        copy(firstIterationMap, other.firstIterationMap, offset, count);
+        copy(lastIterationMap, other.lastIterationMap, offset, count);
+        copy(nitcntMap, other.nitcntMap, offset, count);
+        copy(distMap, other.distMap, offset, count);
+        copy(derivReMap, other.derivReMap, offset, count);
+        copy(derivImMap, other.derivImMap, offset, count);
+        copy(normalReMap, other.normalReMap, offset, count);
+        copy(normalImMap, other.normalImMap, offset, count);
+    }
+
+    // Merge the channel statistics
+    for (isize i = 0; i < 7; i++) {
+        stats[i].update(other.stats[i].min, other.stats[i].max);
+    }
+
+    // Extend the drill area
+    areaUL = Coord(std::min(areaUL.x, other.areaUL.x), std::min(areaUL.y, other.areaUL.y));
+    areaLR = Coord(std::max(areaLR.x, other.areaLR.x), std::max(areaLR.y, other.areaLR.y));
+
+    // Declare all textures as being outdated
+    dirty = true;
+}
+
+isize
+DrillMap::unprocessed() const
+{
+    isize result = 0;
+
+    for (isize y = areaUL.y; y <= areaLR.y; y++) {
+        for (isize x = areaUL.x; x <= areaLR.x; x++) {
+            if (resultMap[y * width + x] == DR_UNPROCESSED) result++;
+        }
+    }
+    return result;
+}
+
+void
+DrillMap::updateStats(isize i)
+{
+    auto update = [&](ChannelID id, const auto &channel) {
+        if (!channel.empty()) stats[id].update(double(channel[i]));
+    };
+
+    stats[CHANNEL_RESULT].update(double(resultMap[i]));
+    stats[CHANNEL_LAST].update(double(lastIterationMap[i]));
+    update(CHANNEL_FIRST, firstIterationMap);
+    update(CHANNEL_NITCNT, nitcntMap);
+    update(CHANNEL_DIST, distMap);
+    update(CHANNEL_DERIVATIVE, derivReMap);
+    update(CHANNEL_DERIVATIVE, derivImMap);
+    update(CHANNEL_NORMAL, normalReMap);
+    update(CHANNEL_NORMAL, normalImMap);
+}
+
+void
+DrillMap::computeStats()
+{
+    auto compute = [&](ChannelID id, const auto &... channels) {
+
+        stats[id].reset();
+
+        auto min = std::numeric_limits<double>::infinity();
+        auto max = -std::numeric_limits<double>::infinity();
+
+        auto scan = [&](const auto &channel) {
+            for (auto value : channel) {
+
+                if (double(value) < min) min = double(value);
+                if (double(value) > max) max = double(value);
+            }
+        };
+        (scan(channels), ...);
+
+        stats[id].update(min, max);
+    };
+
+    derive();
+
+    compute(CHANNEL_RESULT, resultMap);
+    compute(CHANNEL_FIRST, firstIterationMap);
+    compute(CHANNEL_LAST, lastIterationMap);
+    compute(CHANNEL_NITCNT, nitcntMap);
+    compute(CHANNEL_DIST, distMap);
+    compute(CHANNEL_DERIVATIVE, derivReMap, derivImMap);
+    compute(CHANNEL_NORMAL, normalReMap, normalImMap);
+}
+
+bool
+DrillMap::hasDrillResults() const
+{
+    return stats[CHANNEL_RESULT].present;
+}
+
+bool
+DrillMap::hasIterations() const
+{
+    return stats[CHANNEL_LAST].present;
 }
 
 bool
 DrillMap::hasNormalizedIterationCounts() const
 {
-    for (isize i = 0; i < width * height; i++) {
-        if (nitcntMap[i]) return true;
-    }
-    return false;
+    return stats[CHANNEL_NITCNT].present;
 }
 
 bool
 DrillMap::hasDistances() const
 {
-    for (isize i = 0; i < width * height; i++) {
-        if (distMap[i]) return true;
-    }
-    return false;
+    return stats[CHANNEL_DIST].present;
 }
 
 bool
 DrillMap::hasDerivates() const
 {
-    for (isize i = 0; i < width * height; i++) {
-        if (derivReMap[i] || derivImMap[i]) return true;
-    }
-    return false;
+    return stats[CHANNEL_DERIVATIVE].present;
 }
 
 bool
 DrillMap::hasNormals() const
 {
-    for (isize i = 0; i < width * height; i++) {
-        if (normalReMap[i] || normalImMap[i]) return true;
-    }
-    return false;
+    return stats[CHANNEL_NORMAL].present;
 }
 
 void
 DrillMap::updateTextures()
 {
+    derive();
+
     // Only proceed of textures are dirty
     if (!dirty) return;
 
@@ -259,6 +1205,9 @@ DrillMap::updateTextures()
     };
 
     // Generate the overlay image
+    std::vector<u32> overlayMap(width * height);
+    bool hasDist = !distMap.empty();
+
     for (isize y = 0; y < height; y++) {
         for (isize x = 0; x < width; x++) {
             
@@ -274,111 +1223,181 @@ DrillMap::updateTextures()
                 case DR_GLITCH:
 
                     overlayMap[pos] = color(Options::perturbation.color);
-                    distMap[pos] = 0;
+                    if (hasDist) distMap[pos] = 0;
                     break;
                     
                 case DR_IN_BULB:
                 case DR_IN_CARDIOID:
 
                     overlayMap[pos] = color(Options::areacheck.color);
-                    distMap[pos] = 0;
+                    if (hasDist) distMap[pos] = 0;
                     break;
                     
                 case DR_PERIODIC:
 
                     overlayMap[pos] = color(Options::periodcheck.color);
-                    distMap[pos] = 0;
+                    if (hasDist) distMap[pos] = 0;
                     break;
                     
                 case DR_ATTRACTED:
 
                     overlayMap[pos] = color(Options::attractorcheck.color);
-                    distMap[pos] = 0;
+                    if (hasDist) distMap[pos] = 0;
                     break;
                     
                 default:
                     
                     overlayMap[pos] = color();
-                    distMap[pos] = 0;
+                    if (hasDist) distMap[pos] = 0;
                     break;
             }
         }
     }
 
-    iterationMapTex.update((u8 *)lastIterationMap.data());
-    overlayMapTex.update((u8 *)overlayMap.data());
-    nitcntMapTex.update((u8 *)nitcntMap.data());
-    distMapTex.update((u8 *)distMap.data());
-    normalReMapTex.update((u8 *)normalReMap.data());
-    normalImMapTex.update((u8 *)normalImMap.data());
+    // Channels that haven't been allocated are uploaded as zeroes
+    std::vector<u32> zeroes;
+    auto upload = [&](sf::Texture &texture, const auto &channel) {
+        if (channel.empty() && zeroes.empty()) zeroes.assign(width * height, 0);
+        texture.update(channel.empty() ? (u8 *)zeroes.data() : (u8 *)channel.data());
+    };
+
+    upload(iterationMapTex, lastIterationMap);
+    upload(overlayMapTex, overlayMap);
+    upload(nitcntMapTex, nitcntMap);
+    upload(distMapTex, distMap);
+    upload(normalReMapTex, normalReMap);
+    upload(normalImMapTex, normalImMap);
 
     dirty = false;
 }
 
 void
-DrillMap::load(const string &path)
+DrillMap::load(const string &path, isize level)
 {
-    std::ifstream os(path.c_str(), std::ios::binary);
-    if (!os.is_open()) throw Exception("Failed to read file " + path);
-
-    load(os);
+    load(path, level, Coord(isize(0), isize(0)), Coord(isize(MAX_MAP_WIDTH - 1), isize(MAX_MAP_HEIGHT - 1)));
 }
 
 void
-DrillMap::load(std::istream &is)
+DrillMap::load(const string &path, isize level, const Coord &ul, const Coord &lr)
 {
     ProgressIndicator progress1("Loading map file");
 
-    // Load header
-    loadHeader(is);
+    {   std::ifstream is(path.c_str(), std::ios::binary);
+        if (!is.is_open()) throw Exception("Failed to read file " + path);
 
-    // Adjust the map size
-    resize(width, height);
+        // Load header and the directory entries of the requested tiles
+        loadHeader(is, level);
+        loadDirectory(is, level, ul, lr);
+    }
 
-    // The next byte indicates if the map is compressed
-    u8 compressed; is >> compressed;
+    // Restrict the drill area to the requested portion
+    areaUL = Coord(std::max(areaUL.x, ul.x), std::max(areaUL.y, ul.y));
+    areaLR = Coord(std::min(areaLR.x, lr.x), std::min(areaLR.y, lr.y));
 
-    // Load the rest of the file
-    Compressor compressor(width * height * sizeof(MapEntry));
-    compressor << is;
-    progress1.done();
+    if (areaUL.x > areaLR.x || areaUL.y > areaLR.y) {
+        throw Exception("The requested region is outside the map.");
+    }
 
-    // Uncompress the channel data if needed
-    if (compressed) {
+    // Map the channel data into memory
+    mapping = std::make_unique<MappedFile>(path);
+    for (auto &entry : directory) {
 
-        ProgressIndicator progress2("Uncompressing map file");
-        compressor.uncompressData();
+        if (entry.offset + entry.size > u64(mapping->size())) {
+            throw Exception("Not a valid map file. Channel data is truncated.");
+        }
     }
+    progress1.done();
 
-    // Extract all channels
-    ProgressIndicator progress3("Extracting channels");
-    while (!compressor.eof()) { loadChannel(compressor); }
-    progress3.done();
+    // Decode the channels which are needed (others are decoded on demand)
+    ProgressIndicator progress2("Extracting channels");
+    fetch(CHANNEL_RESULT);
+    fetch(CHANNEL_LAST);
+    if (Options::drillmap.first) fetch(CHANNEL_FIRST);
+    if (Options::drillmap.nitcnt) fetch(CHANNEL_NITCNT);
+    if (Options::drillmap.dist) fetch(CHANNEL_DIST);
+    if (Options::drillmap.derivative) fetch(CHANNEL_DERIVATIVE);
+    if (Options::drillmap.normal) fetch(CHANNEL_NORMAL);
+    progress2.done();
 
     // Mark textures as outdated
     dirty = true;
 
     if (Options::flags.verbose) {
 
+        auto status = [&](ChannelID id) {
+
+            for (auto &entry : directory) {
+                if (entry.id == id && stats[id].present) return entry.loaded ? "Loaded" : "Skipped";
+            }
+            return "Not included in map file";
+        };
+
         log::cout << log::vspace;
         log::cout << log::ralign("Map size: ");
         log::cout << width << " x " << height << log::endl;
+        if (level) {
+            log::cout << log::ralign("Mip level: ");
+            log::cout << level << log::endl;
+        }
+        if (isShard()) {
+            log::cout << log::ralign("Drill area: ");
+            log::cout << areaUL << " - " << areaLR << log::endl;
+        }
         log::cout << log::ralign("Drill results: ");
-        log::cout << (hasDrillResults() ? "Loaded" : "Not included in map file") << log::endl;
+        log::cout << status(CHANNEL_RESULT) << log::endl;
         log::cout << log::ralign("Iteration counts: ");
-        log::cout << (hasIterations() ? "Loaded" : "Not included in map file") << log::endl;
+        log::cout << status(CHANNEL_LAST) << log::endl;
         log::cout << log::ralign("Normalized iteration counts: ");
-        log::cout << (hasNormalizedIterationCounts() ? "Loaded" : "Not included in map file") << log::endl;
+        log::cout << status(CHANNEL_NITCNT) << log::endl;
         log::cout << log::ralign("Derivates: ");
-        log::cout << (hasDerivates() ? "Loaded" : "Not included in map file") << log::endl;
+        log::cout << status(CHANNEL_DERIVATIVE) << log::endl;
         log::cout << log::ralign("Normals: ");
-        log::cout << (hasNormals() ? "Loaded" : "Not included in map file") << log::endl;
+        log::cout << status(CHANNEL_NORMAL) << log::endl;
         log::cout << log::vspace;
     }
 }
 
+bool
+DrillMap::fetch(ChannelID id)
+{
+    std::vector<DirectoryEntry *> tiles;
+    for (auto &entry : directory) if (entry.id == id) tiles.push_back(&entry);
+
+    if (tiles.empty()) return false;
+
+    // Allocate the channel before the tiles are decoded in parallel
+    switch (id) {
+
+        case CHANNEL_FIRST:         firstIterationMap.resize(width * height); break;
+        case CHANNEL_NITCNT:        nitcntMap.resize(width * height); break;
+        case CHANNEL_DIST:          distMap.resize(width * height); break;
+        case CHANNEL_DERIVATIVE:    derivReMap.resize(width * height); derivImMap.resize(width * height); break;
+        case CHANNEL_NORMAL:        normalReMap.resize(width * height); normalImMap.resize(width * height); break;
+
+        default:
+            break;
+    }
+
+    Compressor::parallel(isize(tiles.size()), [&](isize i) {
+
+        auto &entry = *tiles[i];
+        if (entry.loaded) return;
+
+        // Decode the tile directly from the mapped file
+        Compressor compressor(mapping->data() + entry.offset, isize(entry.size));
+        if (entry.codec == CODEC_DEFLATE) compressor.uncompressIncrementally();
+        loadChannel(compressor, entry.tile);
+
+        // Drop the file pages which are no longer needed
+        mapping->release(isize(entry.offset), isize(entry.size));
+        entry.loaded = true;
+    });
+
+    return true;
+}
+
 void
-DrillMap::loadHeader(std::istream &is)
+DrillMap::loadHeader(std::istream &is, isize level)
 {
     char magicBytes[10] = { };
 
@@ -393,7 +1412,7 @@ DrillMap::loadHeader(std::istream &is)
     u8 minor;       is >> minor;
     u8 subminor;    is >> subminor;
     u8 beta;        is >> beta;
-    u32 format;     is >> format;
+    u32 format;     is.read((char *)&format, sizeof(format));
 
     // Check check map format
     if (format != MAP_FORMAT) {
@@ -403,117 +1422,160 @@ DrillMap::loadHeader(std::istream &is)
     }
 
     // Read map dimensions
-    is.read((char *)&width, sizeof(width));
-    is.read((char *)&height, sizeof(height));
-}
+    isize w, h;
+    is.read((char *)&w, sizeof(w));
+    is.read((char *)&h, sizeof(h));
 
-void
-DrillMap::loadChannel(Compressor &is)
-{
-    u8 id;  is >> id;
-    u8 fmt; is >> fmt;
-
-    auto loadInt = [&]() {
+    if (w < MIN_MAP_WIDTH || w > MAX_MAP_WIDTH || h < MIN_MAP_HEIGHT || h > MAX_MAP_HEIGHT) {
+        throw Exception("Not a valid map file. Invalid map size.");
+    }
 
-        i64 value;
+    // Determine the size of the requested mip level
+    for (isize i = 0; i < level; i++, w /= 2, h /= 2) {
+        if (!hasNextLevel(w, h)) throw Exception("The map file provides no mip level " + std::to_string(level) + ".");
+    }
+    if (level < 0) throw Exception("Invalid mip level: " + std::to_string(level));
 
-        switch (ChannelFormat(fmt)) {
+    // Adjust the map size
+    resize(w, h);
 
-            case FMT_I8:  load <FMT_I8>  (is, value); break;
-            case FMT_I16: load <FMT_I16> (is, value); break;
-            case FMT_I24: load <FMT_I24> (is, value); break;
-            case FMT_I32: load <FMT_I32> (is, value); break;
+    // Read the drill area (and scale it down to the mip level)
+    is.read((char *)&areaUL, sizeof(areaUL));
+    is.read((char *)&areaLR, sizeof(areaLR));
+    areaUL = Coord(isize(areaUL.x >> level), isize(areaUL.y >> level));
+    areaLR = Coord(isize(areaLR.x >> level), isize(areaLR.y >> level));
 
-            default:
-                throw Exception("Invalid data format");
-        }
+    // Read location parameters
+    auto readString = [&]() {
 
-        return value;
+        u32 len; is.read((char *)&len, sizeof(len));
+        string result(len, ' '); is.read(result.data(), len);
+        return result;
     };
 
-    auto loadFloat = [&]() {
+    location.real = readString();
+    location.imag = readString();
+    location.zoom = readString();
+    is.read((char *)&location.depth, sizeof(location.depth));
+
+    // Read channel statistics
+    for (isize id = 0; id < 7; id++) {
+
+        u8 present; is.read((char *)&present, sizeof(present));
+        double min; is.read((char *)&min, sizeof(min));
+        double max; is.read((char *)&max, sizeof(max));
+
+        stats[id].present = present;
+        stats[id].min = min;
+        stats[id].max = max;
+    }
+}
+
+void
+DrillMap::loadDirectory(std::istream &is, isize level, const Coord &ul, const Coord &lr)
+{
+    bool found = false;
+    u32 count; is.read((char *)&count, sizeof(count));
+
+    for (isize i = 0; i < count; i++) {
+
+        DirectoryEntry entry;
+        u16 x, y, w, h;
+
+        is.read((char *)&entry.id, sizeof(entry.id));
+        is.read((char *)&entry.codec, sizeof(entry.codec));
+        is.read((char *)&entry.level, sizeof(entry.level));
+        is.read((char *)&x, sizeof(x));
+        is.read((char *)&y, sizeof(y));
+        is.read((char *)&w, sizeof(w));
+        is.read((char *)&h, sizeof(h));
+        is.read((char *)&entry.offset, sizeof(entry.offset));
+        is.read((char *)&entry.size, sizeof(entry.size));
+
+        if (!is || entry.id > CHANNEL_DIST || entry.codec > CODEC_DEFLATE) {
+            throw Exception("Not a valid map file. Invalid channel directory.");
+        }
+
+        // Only keep the tiles of the requested mip level covering the requested region
+        if (entry.level != level) continue;
+        found = true;
 
-        double value;
+        entry.tile = Tile { x, y, w, h };
+        if (x + w > width || y + h > height) {
+            throw Exception("Not a valid map file. Invalid tile.");
+        }
+        if (entry.tile.intersects(ul, lr)) directory.push_back(entry);
+    }
 
-        switch (ChannelFormat(fmt)) {
+    if (!found) throw Exception("The map file provides no mip level " + std::to_string(level) + ".");
+}
 
-            case FMT_FP16: load <FMT_FP16> (is, value); break;
-            case FMT_FLOAT: load <FMT_FLOAT> (is, value); break;
-            case FMT_DOUBLE: load <FMT_DOUBLE> (is, value); break;
+void
+DrillMap::loadChannel(Compressor &is, const Tile &tile)
+{
+    u8 id;  is >> id;
+    u8 fmt; is >> fmt;
 
-            default:
-                throw Exception("Invalid data format");
-        }
+    // Shuffled channels specify the XOR transform and the sample format
+    u8 delta = 0;
+    bool shuffled = fmt == FMT_SHUFFLE;
+    if (shuffled) { is >> delta; is >> fmt; }
 
-        return value;
-    };
+    RowReader reader(is, shuffled, delta);
 
     switch (ChannelID(id)) {
 
         case CHANNEL_RESULT:
 
-            for (isize y = 0; y < height; y++) {
-                for (isize x = 0; x < width; x++) {
-                    resultMap[y * width + x] = DrillResult(loadInt());
-                }
+            if (fmt == FMT_RLE) {
+                loadRunLength(is, tile, resultMap);
+            } else {
+                load(reader, tile, ChannelFormat(fmt), resultMap);
             }
             break;
 
         case CHANNEL_FIRST:
 
-            for (isize y = 0; y < height; y++) {
-                for (isize x = 0; x < width; x++) {
-                    firstIterationMap[y * width + x] = u32(loadInt());
-                }
+            if (fmt == FMT_PAETH) {
+                loadPredicted(is, tile, firstIterationMap);
+            } else {
+                load(reader, tile, ChannelFormat(fmt), firstIterationMap);
             }
             break;
 
         case CHANNEL_LAST:
 
-            for (isize y = 0; y < height; y++) {
-                for (isize x = 0; x < width; x++) {
-                    lastIterationMap[y * width + x] = u32(loadInt());
-                }
+            if (fmt == FMT_PAETH) {
+                loadPredicted(is, tile, lastIterationMap);
+            } else {
+                load(reader, tile, ChannelFormat(fmt), lastIterationMap);
             }
             break;
 
         case CHANNEL_NITCNT:
 
-            for (isize y = 0; y < height; y++) {
-                for (isize x = 0; x < width; x++) {
-                    nitcntMap[y * width + x] = float(loadFloat());
-                }
+            if (fmt == FMT_QUANT16) {
+                loadQuantized(is, reader, tile, nitcntMap);
+            } else if (fmt == FMT_HALF) {
+                loadHalf(is, reader, tile, nitcntMap);
+            } else {
+                load(reader, tile, ChannelFormat(fmt), nitcntMap);
             }
             break;
 
         case CHANNEL_DIST:
 
-            for (isize y = 0; y < height; y++) {
-                for (isize x = 0; x < width; x++) {
-                    distMap[y * width + x] = float(loadFloat());
-                }
-            }
-            break;
-
-        case CHANNEL_DERIVATIVE:
-
-            for (isize y = 0; y < height; y++) {
-                for (isize x = 0; x < width; x++) {
-                    derivReMap[y * width + x] = double(loadFloat());
-                    derivImMap[y * width + x] = double(loadFloat());
-                }
+            if (fmt == FMT_QUANT16) {
+                loadQuantized(is, reader, tile, distMap);
+            } else if (fmt == FMT_HALF) {
+                loadHalf(is, reader, tile, distMap);
+            } else {
+                load(reader, tile, ChannelFormat(fmt), distMap);
             }
             break;
 
-        case CHANNEL_NORMAL:
-
-            for (isize y = 0; y < height; y++) {
-                for (isize x = 0; x < width; x++) {
-                    normalReMap[y * width + x] = float(loadFloat());
-                    normalImMap[y * width + x] = float(loadFloat());
-                }
-            }
-            break;
+        case CHANNEL_DERIVATIVE:    load(reader, tile, ChannelFormat(fmt), derivReMap, derivImMap); break;
+        case CHANNEL_NORMAL:        load(reader, tile, ChannelFormat(fmt), normalReMap, normalImMap); break;
 
         default:
 
@@ -521,64 +1583,158 @@ DrillMap::loadChannel(Compressor &is)
     }
 }
 
-template<ChannelFormat fmt, typename T> void
-DrillMap::load(Compressor &is, T &raw)
+template<typename T, typename... Ts> void
+DrillMap::load(RowReader &is, const Tile &tile, ChannelFormat fmt, std::vector<T> &channel, std::vector<Ts> &... more)
 {
-    switch (fmt) {
+    if constexpr (std::is_floating_point_v<T>) {
 
-        case FMT_I8:
-        {
-            i8 value;
-            is >> value;
-            raw = (T)value;
-            break;
-        }
-        case FMT_I16:
-        {
-            i16 value;
-            is >> value;
-            raw = (T)value;
-            break;
+        switch (fmt) {
+
+            case FMT_FP16:      load <FMT_FP16> (is, tile, channel, more...); return;
+            case FMT_FLOAT:     load <FMT_FLOAT> (is, tile, channel, more...); return;
+            case FMT_DOUBLE:    load <FMT_DOUBLE> (is, tile, channel, more...); return;
+
+            default:
+                break;
         }
-        case FMT_I24:
-        {
-            u8 b[3];
-            is >> b[2]; is >> b[1]; is >> b[0];
-            raw = T(((i32)(i8)b[2] << 16) + (b[1] << 8) + b[0]);
-            break;
+
+    } else {
+
+        switch (fmt) {
+
+            case FMT_I8:        load <FMT_I8> (is, tile, channel, more...); return;
+            case FMT_I16:       load <FMT_I16> (is, tile, channel, more...); return;
+            case FMT_I24:       load <FMT_I24> (is, tile, channel, more...); return;
+            case FMT_I32:       load <FMT_I32> (is, tile, channel, more...); return;
+
+            default:
+                break;
         }
-        case FMT_I32:
-        {
-            i32 value;
-            is >> value;
-            raw = (T)value;
-            break;
+    }
+
+    throw Exception("Invalid data format");
+}
+
+template<ChannelFormat fmt, typename... T> void
+DrillMap::load(RowReader &is, const Tile &tile, std::vector<T> &... channels)
+{
+    constexpr isize size = sampleSize(fmt);
+    constexpr isize stride = size * isize(sizeof...(T));
+
+    for (isize y = 0; y < tile.height; y++) {
 
+        auto p = is.next(tile.width, stride);
+        auto i = (tile.y + y) * width + tile.x;
+
+        if constexpr (sizeof...(T) == 1 && (isNative<fmt, T>() && ...)) {
+
+            (std::memcpy(channels.data() + i, p, tile.width * size), ...);
+
+        } else {
+
+            // Samples of multi-component channels are interleaved
+            for (isize x = 0; x < tile.width; x++, i++) {
+                ((channels[i] = decode<fmt, T>(p), p += size), ...);
+            }
         }
-        case FMT_FP16:
-        {
-            i16 value;
-            is >> value;
-            raw = (T)value / (T)INT16_MAX;
-            break;
+    }
+}
+
+void
+DrillMap::loadPredicted(Compressor &is, const Tile &tile, std::vector<u32> &channel)
+{
+    // The next byte specifies the width of the residuals
+    u8 fmt; is >> fmt;
+
+    RowReader reader(is);
+
+    switch (ChannelFormat(fmt)) {
+
+        case FMT_I8:        loadPredicted <FMT_I8> (reader, tile, channel); break;
+        case FMT_I16:       loadPredicted <FMT_I16> (reader, tile, channel); break;
+        case FMT_I24:       loadPredicted <FMT_I24> (reader, tile, channel); break;
+        case FMT_I32:       loadPredicted <FMT_I32> (reader, tile, channel); break;
+
+        default:
+            throw Exception("Invalid data format");
+    }
+}
+
+template<ChannelFormat fmt> void
+DrillMap::loadPredicted(RowReader &is, const Tile &tile, std::vector<u32> &channel)
+{
+    constexpr isize size = sampleSize(fmt);
+
+    // Predictions only refer to samples inside the tile
+    auto origin = channel.data() + tile.y * width + tile.x;
+
+    for (isize y = 0; y < tile.height; y++) {
+
+        auto p = is.next(tile.width, size);
+        for (isize x = 0; x < tile.width; x++, p += size) {
+            origin[y * width + x] = paeth(origin, x, y, width) + u32(decode<fmt, i32>(p));
         }
-        case FMT_FLOAT:
-        {
-            float value;
-            is >> value;
-            raw = (T)value;
-            break;
+    }
+}
+
+void
+DrillMap::loadRunLength(Compressor &is, const Tile &tile, std::vector<DrillResult> &channel)
+{
+    auto count = tile.width * tile.height;
+
+    for (isize i = 0; i < count;) {
+
+        // Each run consists of a value and a variable-length run length
+        i8 value; is >> value;
+        isize run = 0;
+        for (isize shift = 0;; shift += 7) {
+
+            u8 byte; is >> byte;
+            run |= isize(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) break;
         }
-        case FMT_DOUBLE:
-        {
-            double value;
-            is >> value;
-            raw = (T)value;
-            break;
+
+        if (run <= 0 || i + run > count) throw Exception("Corrupted run-length data");
+
+        // Runs may extend over multiple rows of the tile
+        while (run) {
+
+            auto x = i % tile.width, y = i / tile.width;
+            auto n = std::min(run, tile.width - x);
+
+            std::fill_n(channel.begin() + (tile.y + y) * width + tile.x + x, n, DrillResult(value));
+            i += n;
+            run -= n;
         }
     }
 }
 
+void
+DrillMap::loadQuantized(Compressor &is, RowReader &reader, const Tile &tile, std::vector<float> &channel)
+{
+    // The next values specify the value of code 0 and the distance between two codes
+    float offset; is >> offset;
+    float step; is >> step;
+
+    for (isize y = 0; y < tile.height; y++) {
+        dequantize(channel.data() + (tile.y + y) * width + tile.x, reader.next(tile.width, 2), tile.width, offset, step);
+    }
+}
+
+void
+DrillMap::loadHalf(Compressor &is, RowReader &reader, const Tile &tile, std::vector<float> &channel)
+{
+    // The next value specifies the offset which has been subtracted from all samples
+    float offset; is >> offset;
+
+    for (isize y = 0; y < tile.height; y++) {
+
+        auto p = channel.data() + (tile.y + y) * width + tile.x;
+        fromHalf(p, reader.next(tile.width, 2), tile.width);
+        for (isize x = 0; x < tile.width; x++) p[x] += offset;
+    }
+}
+
 void
 DrillMap::save(const string &path)
 {
@@ -591,24 +1747,63 @@ DrillMap::save(const string &path)
 void
 DrillMap::save(std::ostream &os)
 {
-    Compressor compressor(width * height * sizeof(MapEntry));
+    // Replace the incrementally tracked bounds by the exact value ranges
+    computeStats();
+
+    std::vector<std::unique_ptr<DrillMap>> levels;
+    std::vector<DrillMap *> sources;
+    std::vector<DirectoryEntry> entries;
+    std::vector<Compressor> channels;
+
+    auto codec = u8(Options::mapfile.compress ? CODEC_DEFLATE : CODEC_RAW);
 
     {   ProgressIndicator progress1("Preparing map file");
 
-        // Write header
-        saveHeader(os);
+        // Compute the mip levels by repeatedly halving the resolution
+        if (Options::mapfile.tiled) {
+
+            for (auto map = this; hasNextLevel(map->width, map->height); map = levels.back().get()) {
+
+                levels.push_back(std::make_unique<DrillMap>());
+                levels.back()->downsample(*map);
+            }
+        }
+
+        // Split all channels into tiles (untiled maps consist of a single tile)
+        for (isize level = 0; level <= isize(levels.size()); level++) {
+
+            auto &map = level ? *levels[level - 1] : *this;
+            auto size = Options::mapfile.tiled ? tileSize : std::max(map.width, map.height);
+
+            for (auto id : { CHANNEL_RESULT, CHANNEL_LAST, CHANNEL_FIRST, CHANNEL_NITCNT,
+                             CHANNEL_DIST, CHANNEL_DERIVATIVE, CHANNEL_NORMAL }) {
+
+                if (!saves(id)) continue;
+
+                for (isize y = 0; y < map.height; y += size) {
+                    for (isize x = 0; x < map.width; x += size) {
+
+                        auto tile = Tile { x, y, std::min(size, map.width - x), std::min(size, map.height - y) };
+                        entries.push_back(DirectoryEntry { u8(id), codec, u8(level), tile, 0, 0 });
+                        sources.push_back(&map);
+                    }
+                }
+            }
+        }
+
+        // Reserve an upper bound for the size of the channel data
+        channels.reserve(entries.size());
+        for (usize i = 0; i < entries.size(); i++) {
 
-        // The next byte indicates if channel data is compressed
-        os << u8(Options::mapfile.compress);
+            auto id = ChannelID(entries[i].id);
+            auto &tile = entries[i].tile;
+            channels.emplace_back(12 + tile.width * tile.height * components(id) * sampleSize(sources[i]->format(id, tile)));
+        }
 
         // Generate channels
-        if (Options::mapfile.result) saveChannel(compressor, CHANNEL_RESULT);
-        if (Options::mapfile.last) saveChannel(compressor, CHANNEL_LAST);
-        if (Options::mapfile.first) saveChannel(compressor, CHANNEL_FIRST);
-        if (Options::mapfile.nitcnt) saveChannel(compressor, CHANNEL_NITCNT);
-        if (Options::mapfile.dist) saveChannel(compressor, CHANNEL_DIST);
-        if (Options::mapfile.derivative) saveChannel(compressor, CHANNEL_DERIVATIVE);
-        if (Options::mapfile.normal) saveChannel(compressor, CHANNEL_NORMAL);
+        Compressor::parallel(isize(entries.size()), [&](isize i) {
+            sources[i]->saveChannel(channels[i], ChannelID(entries[i].id), entries[i].tile);
+        });
     }
 
     if (Options::flags.verbose) {
@@ -616,6 +1811,14 @@ DrillMap::save(std::ostream &os)
         log::cout << log::vspace;
         log::cout << log::ralign("Map size: ");
         log::cout << width << " x " << height << log::endl;
+        if (isShard()) {
+            log::cout << log::ralign("Drill area: ");
+            log::cout << areaUL << " - " << areaLR << log::endl;
+        }
+        if (Options::mapfile.tiled) {
+            log::cout << log::ralign("Mip levels: ");
+            log::cout << isize(levels.size()) + 1 << log::endl;
+        }
         log::cout << log::ralign("Drill results: ");
         log::cout << (Options::mapfile.result ? "Saved" : "Not saved") << log::endl;
         log::cout << log::ralign("Iteration counts: ");
@@ -637,9 +1840,20 @@ DrillMap::save(std::ostream &os)
 
         ProgressIndicator progress2("Compressing map file");
 
-        auto oldSize = compressor.size();
-        compressor.compressData();
-        auto newSize = compressor.size();
+        std::atomic<isize> oldSize = 0, newSize = 0;
+        auto compress = [&](isize i) {
+
+            oldSize += channels[i].size();
+            channels[i].compressData();
+            newSize += channels[i].size();
+        };
+
+        // Large channels are compressed chunk by chunk in parallel, tiles as a whole
+        if (Options::mapfile.tiled) {
+            Compressor::parallel(isize(channels.size()), compress);
+        } else {
+            for (isize i = 0; i < isize(channels.size()); i++) compress(i);
+        }
         auto saved = oldSize - newSize;
         progress2.done();
 
@@ -653,7 +1867,36 @@ DrillMap::save(std::ostream &os)
     }
 
     ProgressIndicator progress3("Saving map file");
-    compressor >> os;
+
+    // Write header
+    saveHeader(os);
+
+    // Write the channel directory (the tiles follow in the same order)
+    auto count = u32(entries.size());
+    auto offset = u64(os.tellp()) + sizeof(count) + count * (3 + 4 * sizeof(u16) + 2 * sizeof(u64));
+    os.write((char *)&count, sizeof(count));
+
+    for (usize i = 0; i < entries.size(); i++) {
+
+        auto &entry = entries[i];
+        u16 x = u16(entry.tile.x), y = u16(entry.tile.y);
+        u16 w = u16(entry.tile.width), h = u16(entry.tile.height);
+        u64 size = u64(channels[i].size());
+
+        os.write((char *)&entry.id, sizeof(entry.id));
+        os.write((char *)&entry.codec, sizeof(entry.codec));
+        os.write((char *)&entry.level, sizeof(entry.level));
+        os.write((char *)&x, sizeof(x));
+        os.write((char *)&y, sizeof(y));
+        os.write((char *)&w, sizeof(w));
+        os.write((char *)&h, sizeof(h));
+        os.write((char *)&offset, sizeof(offset));
+        os.write((char *)&size, sizeof(size));
+        offset += size;
+    }
+
+    // Write channel data
+    for (auto &channel : channels) channel >> os;
 }
 
 void
@@ -667,142 +1910,377 @@ DrillMap::saveHeader(std::ostream &os)
     os << u8(VER_MINOR);
     os << u8(VER_SUBMINOR);
     os << u8(VER_BETA);
-    os << u32(MAP_FORMAT);
+    u32 format = MAP_FORMAT; os.write((char *)&format, sizeof(format));
 
     // Write map dimensions
     os.write((char *)&width, sizeof(width));
     os.write((char *)&height, sizeof(height));
+
+    // Write the drill area
+    os.write((char *)&areaUL, sizeof(areaUL));
+    os.write((char *)&areaLR, sizeof(areaLR));
+
+    // Write location parameters
+    auto writeString = [&](const string &s) {
+
+        u32 len = u32(s.length()); os.write((char *)&len, sizeof(len));
+        os.write(s.data(), len);
+    };
+
+    writeString(location.real);
+    writeString(location.imag);
+    writeString(location.zoom);
+    os.write((char *)&location.depth, sizeof(location.depth));
+
+    // Write channel statistics (cleared for all channels that aren't saved)
+    for (isize id = 0; id < 7; id++) {
+
+        bool saved = saves(ChannelID(id));
+        u8 present = saved && stats[id].present;
+        double min = saved ? stats[id].min.load() : std::numeric_limits<double>::infinity();
+        double max = saved ? stats[id].max.load() : -std::numeric_limits<double>::infinity();
+
+        os.write((char *)&present, sizeof(present));
+        os.write((char *)&min, sizeof(min));
+        os.write((char *)&max, sizeof(max));
+    }
+}
+
+bool
+DrillMap::saves(ChannelID id) const
+{
+    switch (id) {
+
+        case CHANNEL_RESULT:        return Options::mapfile.result;
+        case CHANNEL_LAST:          return Options::mapfile.last;
+        case CHANNEL_FIRST:         return Options::mapfile.first && !firstIterationMap.empty();
+        case CHANNEL_NITCNT:        return Options::mapfile.nitcnt && !nitcntMap.empty();
+        case CHANNEL_DIST:          return Options::mapfile.dist && !distMap.empty();
+        case CHANNEL_DERIVATIVE:    return Options::mapfile.derivative && !derivReMap.empty();
+        case CHANNEL_NORMAL:        return Options::mapfile.normal && !normalReMap.empty();
+
+        default:
+            return false;
+    }
+}
+
+ChannelFormat
+DrillMap::format(ChannelID id, const Tile &tile) const
+{
+    /* Half-precision numbers carry 11 significant bits and overflow above
+     * 65504. They are stored relative to the tile minimum. Normalized
+     * iteration counts need an absolute precision. Hence, tiles spanning more
+     * than 256 iterations, where the step size would exceed 1/8, are stored
+     * in single precision. Distance estimates only need a relative precision
+     * and fall back to single precision if their range overflows.
+     */
+    auto fitsHalf = [&](const std::vector<float> &channel, float limit) {
+
+        auto [min, max] = range(channel, tile);
+        return !(max - min > limit);
+    };
+
+    switch (id) {
+
+        case CHANNEL_RESULT:        return Options::mapfile.predict ? FMT_RLE : FMT_I8;
+        case CHANNEL_NORMAL:        return FMT_FP16;
+        case CHANNEL_NITCNT:
+        case CHANNEL_DIST:
+
+            switch (Options::mapfile.precision) {
+
+                case FloatPrecision::Half:
+
+                    if (id == CHANNEL_NITCNT) return fitsHalf(nitcntMap, 256.0f) ? FMT_HALF : FMT_FLOAT;
+                    return fitsHalf(distMap, 65504.0f) ? FMT_HALF : FMT_FLOAT;
+
+                case FloatPrecision::Quantized: return FMT_QUANT16;
+
+                default:
+                    return FMT_FLOAT;
+            }
+
+        case CHANNEL_FIRST:
+        case CHANNEL_LAST:          return Options::mapfile.predict ? FMT_PAETH : FMT_I32;
+
+        default:
+            return FMT_FLOAT;
+    }
+}
+
+isize
+DrillMap::components(ChannelID id)
+{
+    return id == CHANNEL_DERIVATIVE || id == CHANNEL_NORMAL ? 2 : 1;
 }
 
 void
-DrillMap::saveChannel(Compressor &os, ChannelID id)
+DrillMap::saveChannel(Compressor &os, ChannelID id, const Tile &tile)
 {
+    auto fmt = format(id, tile);
+    auto shuffled = Options::mapfile.shuffle && (fmt == FMT_FP16 || fmt == FMT_FLOAT || fmt == FMT_DOUBLE ||
+                                                 fmt == FMT_HALF || fmt == FMT_QUANT16);
+
+    os << u8(id);
+
+    // Floating-point channels are optionally split into byte planes
+    if (shuffled) os << u8(FMT_SHUFFLE) << u8(Options::mapfile.xorshuffle);
+    os << u8(fmt);
+
     switch (id) {
 
         case CHANNEL_RESULT:
 
-            os << u8(id) << u8(FMT_I8);
-            for (isize y = 0; y < height; y++) {
-                for (isize x = 0; x < width; x++) {
-                    save <FMT_I8> (os, i8(resultMap[y * width + x]));
-                }
+            if (fmt == FMT_RLE) {
+                saveRunLength(os, tile, resultMap);
+            } else {
+                save(os, tile, fmt, resultMap);
             }
             break;
 
         case CHANNEL_FIRST:
 
-            os << u8(id) << u8(FMT_I32);
-            for (isize y = 0; y < height; y++) {
-                for (isize x = 0; x < width; x++) {
-                    save <FMT_I32> (os, firstIterationMap[y * width + x]);
-                }
+            if (fmt == FMT_PAETH) {
+                savePredicted(os, tile, firstIterationMap);
+            } else {
+                save(os, tile, fmt, firstIterationMap);
             }
             break;
 
         case CHANNEL_LAST:
 
-            os << u8(id) << u8(FMT_I32);
-            for (isize y = 0; y < height; y++) {
-                for (isize x = 0; x < width; x++) {
-                    save <FMT_I32> (os, lastIterationMap[y * width + x]);
-                }
+            if (fmt == FMT_PAETH) {
+                savePredicted(os, tile, lastIterationMap);
+            } else {
+                save(os, tile, fmt, lastIterationMap);
             }
             break;
 
         case CHANNEL_NITCNT:
 
-            os << u8(id) << u8(FMT_FLOAT);
-            for (isize y = 0; y < height; y++) {
-                for (isize x = 0; x < width; x++) {
-                    save <FMT_FLOAT> (os, nitcntMap[y * width + x]);
-                }
+            if (fmt == FMT_QUANT16) {
+                saveQuantized(os, tile, nitcntMap);
+            } else if (fmt == FMT_HALF) {
+                saveHalf(os, tile, nitcntMap);
+            } else {
+                save(os, tile, fmt, nitcntMap);
             }
             break;
 
         case CHANNEL_DIST:
 
-            os << u8(id) << u8(FMT_FLOAT);
-            for (isize y = 0; y < height; y++) {
-                for (isize x = 0; x < width; x++) {
-                    save <FMT_FLOAT> (os, distMap[y * width + x]);
-                }
+            if (fmt == FMT_QUANT16) {
+                saveQuantized(os, tile, distMap);
+            } else if (fmt == FMT_HALF) {
+                saveHalf(os, tile, distMap);
+            } else {
+                save(os, tile, fmt, distMap);
             }
             break;
 
-        case CHANNEL_DERIVATIVE:
+        case CHANNEL_DERIVATIVE:    save(os, tile, fmt, derivReMap, derivImMap); break;
+        case CHANNEL_NORMAL:        save(os, tile, fmt, normalReMap, normalImMap); break;
 
-            os << u8(id) << u8(FMT_FLOAT);
-            for (isize y = 0; y < height; y++) {
-                for (isize x = 0; x < width; x++) {
-                    save <FMT_FLOAT> (os, derivReMap[y * width + x]);
-                    save <FMT_FLOAT> (os, derivImMap[y * width + x]);
-                }
-            }
-            break;
+        default:
 
-        case CHANNEL_NORMAL:
+            throw Exception("Invalid channel ID: " + std::to_string(id));
+    }
 
-            os << u8(id) << u8(FMT_FP16);
-            for (isize y = 0; y < height; y++) {
-                for (isize x = 0; x < width; x++) {
-                    save <FMT_FP16> (os, normalReMap[y * width + x]);
-                    save <FMT_FP16> (os, normalImMap[y * width + x]);
-                }
-            }
-            break;
+    // The samples are located at the end (format parameters may precede them)
+    if (shuffled) {
 
-        default:
+        auto stride = components(id) * sampleSize(fmt);
+        auto samples = os.data() + os.size() - tile.width * tile.height * stride;
+        shuffle(samples, tile.width, tile.height, stride, Options::mapfile.xorshuffle);
+    }
+}
 
-            throw Exception("Invalid channel ID: " + std::to_string(id));
+template<typename T, typename... Ts> void
+DrillMap::save(Compressor &os, const Tile &tile, ChannelFormat fmt, const std::vector<T> &channel, const std::vector<Ts> &... more)
+{
+    if constexpr (std::is_floating_point_v<T>) {
+
+        switch (fmt) {
+
+            case FMT_FP16:      save <FMT_FP16> (os, tile, channel, more...); return;
+            case FMT_FLOAT:     save <FMT_FLOAT> (os, tile, channel, more...); return;
+            case FMT_DOUBLE:    save <FMT_DOUBLE> (os, tile, channel, more...); return;
+
+            default:
+                break;
+        }
+
+    } else {
+
+        switch (fmt) {
+
+            case FMT_I8:        save <FMT_I8> (os, tile, channel, more...); return;
+            case FMT_I16:       save <FMT_I16> (os, tile, channel, more...); return;
+            case FMT_I24:       save <FMT_I24> (os, tile, channel, more...); return;
+            case FMT_I32:       save <FMT_I32> (os, tile, channel, more...); return;
+
+            default:
+                break;
+        }
+    }
+
+    throw Exception("Invalid data format");
+}
+
+template<ChannelFormat fmt, typename... T> void
+DrillMap::save(Compressor &os, const Tile &tile, const std::vector<T> &... channels)
+{
+    constexpr isize size = sampleSize(fmt);
+
+    auto p = os.append(tile.width * tile.height * size * isize(sizeof...(T)));
+
+    for (isize y = 0; y < tile.height; y++) {
+
+        auto i = (tile.y + y) * width + tile.x;
+
+        if constexpr (sizeof...(T) == 1 && (isNative<fmt, T>() && ...)) {
+
+            (std::memcpy(p, channels.data() + i, tile.width * size), ...);
+            p += tile.width * size;
+
+        } else {
+
+            // Samples of multi-component channels are interleaved
+            for (isize x = 0; x < tile.width; x++, i++) {
+                ((encode<fmt>(p, channels[i]), p += size), ...);
+            }
+        }
     }
 }
 
-template<ChannelFormat fmt, typename T> void
-DrillMap::save(Compressor &os, T raw)
+void
+DrillMap::savePredicted(Compressor &os, const Tile &tile, const std::vector<u32> &channel)
 {
-    switch (fmt) {
+    // Predictions only refer to samples inside the tile
+    auto origin = channel.data() + tile.y * width + tile.x;
 
-        case FMT_I8:
+    // Determine the range of the residuals
+    i32 min = 0, max = 0;
+    for (isize y = 0; y < tile.height; y++) {
+        for (isize x = 0; x < tile.width; x++) {
 
-            os << (i8)raw;
-            break;
+            auto residual = i32(origin[y * width + x] - paeth(origin, x, y, width));
+            min = std::min(min, residual);
+            max = std::max(max, residual);
+        }
+    }
 
-        case FMT_I16:
+    // Select the narrowest format that can hold all residuals
+    auto fits = [&](i32 bits) { return min >= -(1 << (bits - 1)) && max < (1 << (bits - 1)); };
+    auto fmt = fits(8) ? FMT_I8 : fits(16) ? FMT_I16 : fits(24) ? FMT_I24 : FMT_I32;
+    os << u8(fmt);
 
-            os << (i16)raw;
-            break;
+    switch (fmt) {
 
-        case FMT_I24:
+        case FMT_I8:        savePredicted <FMT_I8> (os, tile, channel); break;
+        case FMT_I16:       savePredicted <FMT_I16> (os, tile, channel); break;
+        case FMT_I24:       savePredicted <FMT_I24> (os, tile, channel); break;
 
-            os << (u8)((i32)raw >> 16);
-            os << (u8)((i32)raw >> 8);
-            os << (u8)((i32)raw);
-            break;
+        default:
+            savePredicted <FMT_I32> (os, tile, channel);
+    }
+}
 
-        case FMT_I32:
+template<ChannelFormat fmt> void
+DrillMap::savePredicted(Compressor &os, const Tile &tile, const std::vector<u32> &channel)
+{
+    constexpr isize size = sampleSize(fmt);
 
-            os << (i32)raw;
-            break;
+    auto origin = channel.data() + tile.y * width + tile.x;
+    auto p = os.append(tile.width * tile.height * size);
 
-        case FMT_FP16:
-        {
-            i16 value = (i16)(raw * (T)INT16_MAX);
-            os << value;
-            break;
+    for (isize y = 0; y < tile.height; y++) {
+        for (isize x = 0; x < tile.width; x++, p += size) {
+            encode<fmt>(p, i32(origin[y * width + x] - paeth(origin, x, y, width)));
         }
-        case FMT_FLOAT:
-        {
-            float value = (float)raw;
-            os << value;
-            break;
+    }
+}
+
+void
+DrillMap::saveRunLength(Compressor &os, const Tile &tile, const std::vector<DrillResult> &channel)
+{
+    DrillResult value = DR_UNPROCESSED;
+    isize run = 0;
+
+    // Each run consists of a value and a variable-length run length
+    auto emit = [&]() {
+
+        os << i8(value);
+        for (auto rest = run; rest; rest >>= 7) {
+            os << u8((rest & 0x7F) | (rest > 0x7F ? 0x80 : 0));
         }
-        case FMT_DOUBLE:
-        {
-            double value = (double)raw;
-            os << value;
-            break;
+    };
+
+    // Runs may extend over multiple rows of the tile
+    for (isize y = 0; y < tile.height; y++) {
+
+        auto p = channel.data() + (tile.y + y) * width + tile.x;
+        for (isize x = 0; x < tile.width; x++) {
+
+            if (run && p[x] == value) { run++; continue; }
+            if (run) emit();
+            value = p[x];
+            run = 1;
+        }
+    }
+    if (run) emit();
+}
+
+std::pair<float, float>
+DrillMap::range(const std::vector<float> &channel, const Tile &tile) const
+{
+    float min = std::numeric_limits<float>::infinity();
+    float max = -std::numeric_limits<float>::infinity();
+
+    for (isize y = 0; y < tile.height; y++) {
+        for (isize x = 0; x < tile.width; x++) {
+
+            auto value = channel[(tile.y + y) * width + tile.x + x];
+            if (std::isfinite(value)) { min = std::min(min, value); max = std::max(max, value); }
         }
     }
+    return { min, max };
+}
+
+void
+DrillMap::saveQuantized(Compressor &os, const Tile &tile, const std::vector<float> &channel)
+{
+    auto [min, max] = range(channel, tile);
+
+    // Spread the codes evenly over the value range (the step size grows with the range)
+    auto offset = min <= max ? min : 0.0f;
+    auto step = (max - min) / 65535.0f;
+    if (!(step > 0) || !std::isfinite(step)) step = 1.0f;
+    os << offset << step;
+
+    auto p = os.append(tile.width * tile.height * 2);
+    for (isize y = 0; y < tile.height; y++, p += tile.width * 2) {
+        quantize(p, channel.data() + (tile.y + y) * width + tile.x, tile.width, offset, 1.0f / step);
+    }
+}
+
+void
+DrillMap::saveHalf(Compressor &os, const Tile &tile, const std::vector<float> &channel)
+{
+    auto [min, max] = range(channel, tile);
+
+    // Store all samples relative to the minimum to keep them small
+    auto offset = min <= max ? min : 0.0f;
+    os << offset;
+
+    std::vector<float> row(tile.width);
+    auto p = os.append(tile.width * tile.height * 2);
+    for (isize y = 0; y < tile.height; y++, p += tile.width * 2) {
+
+        auto src = channel.data() + (tile.y + y) * width + tile.x;
+        for (isize x = 0; x < tile.width; x++) row[x] = src[x] - offset;
+        toHalf(p, row.data(), tile.width);
+    }
 }
 
 }
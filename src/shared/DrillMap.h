@@ -16,9 +16,14 @@
 #include "StandardComplex.h"
 #include "ExtendedComplex.h"
 #include "PrecisionComplex.h"
+#include "Coord.h"
 #include "Compressor.h"
+#include "MappedFile.h"
 
 #include <SFML/Graphics.hpp>
+#include <atomic>
+#include <limits>
+#include <memory>
 
 namespace dd {
 
@@ -40,9 +45,14 @@ enum ChannelFormat {
     FMT_I16,
     FMT_I24,
     FMT_I32,
-    FMT_FP16,
+    FMT_FP16,       // Fixed-point values in [-1, 1]
     FMT_FLOAT,
-    FMT_DOUBLE
+    FMT_DOUBLE,
+    FMT_PAETH,      // Paeth predicted residuals (integer channels)
+    FMT_RLE,        // Run-length encoded values (drill results)
+    FMT_SHUFFLE,    // Byte planes of another format (floating-point channels)
+    FMT_HALF,       // IEEE 754 half-precision values relative to an offset
+    FMT_QUANT16     // Unsigned 16-bit codes with an offset and a step size (range / 65535)
 };
 
 enum ChannelID {
@@ -56,6 +66,43 @@ enum ChannelID {
     CHANNEL_DIST,       // Distance estimates
 };
 
+enum ChannelCodec {
+
+    CODEC_RAW,          // Stored as is
+    CODEC_DEFLATE,      // Deflated in independent chunks
+};
+
+// Rectangular portion of a map
+struct Tile {
+
+    isize x = 0;
+    isize y = 0;
+    isize width = 0;
+    isize height = 0;
+
+    bool intersects(const Coord &ul, const Coord &lr) const {
+        return x <= lr.x && y <= lr.y && x + width > ul.x && y + height > ul.y;
+    }
+};
+
+struct DirectoryEntry {
+
+    // Stored channel and its codec
+    u8 id;
+    u8 codec;
+
+    // Mip level and the covered portion of the map (in level coordinates)
+    u8 level;
+    Tile tile;
+
+    // Location of the channel data inside the map file
+    u64 offset;
+    u64 size;
+
+    // Indicates if the channel has been decoded
+    bool loaded = false;
+};
+
 struct MapEntry {
 
     // Drill outcome
@@ -72,13 +119,59 @@ struct MapEntry {
     
     // Derivative
     ExtendedComplex derivative;
+};
+
+struct ChannelStats {
+
+    // Indicates if the channel contains a nonzero value
+    std::atomic<bool> present = false;
+
+    // Value range of the channel (a bound while drilling, exact in map files)
+    std::atomic<double> min = std::numeric_limits<double>::infinity();
+    std::atomic<double> max = -std::numeric_limits<double>::infinity();
+
+    void reset();
+    void update(double value);
+    void update(double minValue, double maxValue);
+};
+
+struct RawEntry {
 
-    // Normal vector
-    ExtendedComplex normal;
+    // Last iteration value before the escape check hit (mantissa and exponent)
+    float znRe, znIm;
+    i32 znExp;
+
+    // Derivative (mantissa and exponent)
+    i32 dnExp;
+    float dnRe, dnIm;
+};
+
+// Reads channel data row by row and reverts the byte shuffling if needed
+class RowReader {
+
+    Compressor &is;
+
+    // Shuffle parameters
+    bool shuffled;
+    bool delta;
+
+    // Unshuffled row and the last record of the previous row
+    std::vector<u8> row;
+    std::vector<u8> prev;
+
+public:
+
+    RowReader(Compressor &is, bool shuffled = false, bool delta = false) : is(is), shuffled(shuffled), delta(delta) { }
+
+    // Returns the next row consisting of width records with stride bytes each
+    const u8 *next(isize width, isize stride);
 };
 
 class DrillMap {
 
+    // Edge length of the tiles in tiled map files
+    static constexpr isize tileSize = 256;
+
 public:
     
     // Map resolution
@@ -96,19 +189,40 @@ public:
     mpf_class mpfPixelDelta;
     ExtendedDouble pixelDelta;
 
-    // Map data
+    // Drill area (differs from the full map if the map is a shard)
+    Coord areaUL;
+    Coord areaLR;
+
+    // Sum of two row indices mapping onto conjugate complex numbers (or -1)
+    isize mirrorSum = -1;
+
+    // Location parameters (used to verify that shards belong together)
+    struct { string real; string imag; string zoom; isize depth = 0; } location;
+
+    // Map data (optional channels are empty if they haven't been allocated)
     std::vector<DrillResult> resultMap;
     std::vector<u32> firstIterationMap;
     std::vector<u32> lastIterationMap;
-    std::vector<u32> overlayMap;
-    std::vector<u32> textureMap;
     std::vector<float> nitcntMap;
     std::vector<float> distMap;
-    std::vector<double> derivReMap;
-    std::vector<double> derivImMap;
+    std::vector<float> derivReMap;
+    std::vector<float> derivImMap;
     std::vector<float> normalReMap;
     std::vector<float> normalImMap;
 
+    // Presence and value ranges of all channels (indexed by ChannelID)
+    ChannelStats stats[7];
+
+    // Final orbit states of escaped pixels whose channels haven't been derived
+    std::vector<RawEntry> rawMap;
+
+    // Indicates whether some pixels are waiting to be derived
+    std::atomic<bool> pending = false;
+
+    // Channel directory and memory mapping of the loaded map file
+    std::vector<DirectoryEntry> directory;
+    std::unique_ptr<MappedFile> mapping;
+
     // Map data in texture format
     sf::Texture iterationMapTex;
     sf::Texture overlayMapTex;
@@ -118,7 +232,7 @@ public:
     sf::Texture normalImMapTex;
 
     // Indicates whether texture maps are dirty
-    bool dirty = true;
+    std::atomic<bool> dirty = true;
 
     const sf::Texture &getIterationMapTex() { updateTextures(); return iterationMapTex; }
     const sf::Texture &getOverlayMapTex() { updateTextures(); return overlayMapTex; }
@@ -134,9 +248,21 @@ public:
 
 public:
 
+    // Resizes the map and allocates all channels needed by the current options
     void resize();
+
+    // Turns the map into a half-resolution copy of another map
+    void downsample(const DrillMap &source);
+
+    // Indicates if a map of the given size has a half-resolution mip level
+    static bool hasNextLevel(isize w, isize h);
+
+    // Resizes the map and allocates the drill results and iteration counts
     void resize(isize w, isize h);
 
+    // Allocates all optional channels needed for drilling with the current options
+    void allocate();
+
 
     //
     // Accessing
@@ -148,10 +274,26 @@ public:
     void set(const struct Coord &c, const MapEntry &entry);
 
 
+    //
+    // Deriving
+    //
+
+public:
+
+    // Computes all channels of escaped pixels from their final orbit values
+    void derive();
+
+private:
+
+    void derive(isize y, double logEscape, const ExtendedDouble &invDelta);
+
+
     //
     // Locating
     //
 
+public:
+
     // Translates a coordinate into a complex number and vice versa
     PrecisionComplex translate(const Coord &coord) const;
     Coord translate(const PrecisionComplex &coord) const;
@@ -162,9 +304,62 @@ public:
     // Computes the distance from the center
     ExtendedComplex distance(const Coord &coord) const;
 
-    // Returns the coordinates of a mesh covering the drill map
+    // Returns the coordinates of a mesh covering the drill area
     void getMesh(isize numx, isize numy, std::vector<Coord> &meshPoints) const;
 
+    // Arranges coordinates such that the coarse lattices used by fill() come first
+    void sortCoarseToFine(std::vector<Coord> &coords) const;
+
+
+    //
+    // Mirroring
+    //
+
+public:
+
+    // Returns the row whose pixels are the complex conjugates of row y (or -1)
+    isize mirrorRow(isize y) const;
+
+    // Indicates if a row is computed by mirroring another row of the drill area
+    bool isMirrored(isize y) const;
+
+    // Fills all mirrored rows with the conjugated drill results
+    void mirror();
+
+
+    //
+    // Interpolating
+    //
+
+public:
+
+    // Fills all unprocessed pixels of a rectangle by bilinear interpolation
+    // (channels must have been derived)
+    void interpolate(const Coord &ul, const Coord &lr);
+
+    // Fills all unresolved pixels with a resolved pixel of a coarser lattice
+    void fill();
+
+    // Fills an unresolved pixel with the average of its resolved neighbors
+    // (channels must have been derived)
+    bool inpaint(const Coord &c, isize minNeighbors = 4);
+
+
+    //
+    // Merging
+    //
+
+public:
+
+    // Indicates if the drill area covers only a portion of the map
+    bool isShard() const;
+
+    // Copies the drill area of another map (shard) into this map
+    void merge(const DrillMap &other);
+
+    // Counts the pixels of the drill area that haven't been drilled
+    isize unprocessed() const;
+
 
     //
     // Analyzing
@@ -172,6 +367,13 @@ public:
 
 public:
 
+    // Extends the channel statistics by the values of a single pixel
+    void updateStats(isize i);
+
+    // Recomputes the exact channel statistics from the channel data
+    void computeStats();
+
+    // Checks if a channel contains nonzero values (O(1) due to the statistics)
     bool hasDrillResults() const;
     bool hasIterations() const;
     bool hasNormalizedIterationCounts() const;
@@ -195,18 +397,26 @@ public:
 
 public:
 
-    void load(const string &path);
-    void load(std::istream &is);
+    void load(const string &path, isize level = 0);
+
+    // Loads the portion ul ... lr of a mip level (in level coordinates)
+    void load(const string &path, isize level, const Coord &ul, const Coord &lr);
+
+    // Decodes a channel of the loaded map file if it hasn't been decoded yet
+    bool fetch(ChannelID id);
 
 private:
 
-    void loadHeader(std::istream &is);
-    void loadChannel(Compressor &is);
-    template<ChannelFormat fmt, typename T> void load(Compressor &is, T &raw);
-    template<ChannelFormat fmt> void load(Compressor &is, u32 &raw) { load <fmt,u32> (is, raw); }
-    template<ChannelFormat fmt> void load(Compressor &is, u64 &raw) { load <fmt,u64> (is, raw); }
-    template<ChannelFormat fmt> void load(Compressor &is, float &raw) { load <fmt,float> (is, raw); }
-    template<ChannelFormat fmt> void load(Compressor &is, double &raw) { load <fmt,double> (is, raw); }
+    void loadHeader(std::istream &is, isize level);
+    void loadDirectory(std::istream &is, isize level, const Coord &ul, const Coord &lr);
+    void loadChannel(Compressor &is, const Tile &tile);
+    template<typename T, typename... Ts> void load(RowReader &is, const Tile &tile, ChannelFormat fmt, std::vector<T> &channel, std::vector<Ts> &... more);
+    template<ChannelFormat fmt, typename... T> void load(RowReader &is, const Tile &tile, std::vector<T> &... channels);
+    void loadPredicted(Compressor &is, const Tile &tile, std::vector<u32> &channel);
+    template<ChannelFormat fmt> void loadPredicted(RowReader &is, const Tile &tile, std::vector<u32> &channel);
+    void loadRunLength(Compressor &is, const Tile &tile, std::vector<DrillResult> &channel);
+    void loadQuantized(Compressor &is, RowReader &reader, const Tile &tile, std::vector<float> &channel);
+    void loadHalf(Compressor &is, RowReader &reader, const Tile &tile, std::vector<float> &channel);
 
     
     //
@@ -221,12 +431,20 @@ public:
 private:
 
     void saveHeader(std::ostream &os);
-    void saveChannel(Compressor &os, ChannelID id);
-    template<ChannelFormat fmt, typename T> void save(Compressor &os, T raw);
-    template<ChannelFormat fmt> void save(Compressor &os, u32 raw) { save <fmt,u32> (os, raw); }
-    template<ChannelFormat fmt> void save(Compressor &os, u64 raw) { save <fmt,u64> (os, raw); }
-    template<ChannelFormat fmt> void save(Compressor &os, float raw) { save <fmt,float> (os, raw); }
-    template<ChannelFormat fmt> void save(Compressor &os, double raw) { save <fmt,double> (os, raw); }
+    bool saves(ChannelID id) const;
+    ChannelFormat format(ChannelID id, const Tile &tile) const;
+    static isize components(ChannelID id);
+    void saveChannel(Compressor &os, ChannelID id, const Tile &tile);
+    template<typename T, typename... Ts> void save(Compressor &os, const Tile &tile, ChannelFormat fmt, const std::vector<T> &channel, const std::vector<Ts> &... more);
+    template<ChannelFormat fmt, typename... T> void save(Compressor &os, const Tile &tile, const std::vector<T> &... channels);
+    void savePredicted(Compressor &os, const Tile &tile, const std::vector<u32> &channel);
+    template<ChannelFormat fmt> void savePredicted(Compressor &os, const Tile &tile, const std::vector<u32> &channel);
+    void saveRunLength(Compressor &os, const Tile &tile, const std::vector<DrillResult> &channel);
+    void saveQuantized(Compressor &os, const Tile &tile, const std::vector<float> &channel);
+    void saveHalf(Compressor &os, const Tile &tile, const std::vector<float> &channel);
+
+    // Returns the range of all finite values inside a tile
+    std::pair<float, float> range(const std::vector<float> &channel, const Tile &tile) const;
 };
 
 }
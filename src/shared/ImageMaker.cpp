@@ -17,7 +17,7 @@
 namespace dd {
 
 void
-ImageMaker::init()
+ImageMaker::init(const DrillMap &map)
 {
     // Only proceed if initialization hasn't been done yet
     if (colorizer.getSize().x != 0) return;
@@ -33,7 +33,7 @@ ImageMaker::init()
     }
 
     // Setup GPU filters
-    auto mapDim = sf::Vector2u(unsigned(Options::drillmap.width), unsigned(Options::drillmap.height));
+    auto mapDim = sf::Vector2u(unsigned(map.width), unsigned(map.height));
     auto imageDim = sf::Vector2u(unsigned(Options::image.width), unsigned(Options::image.height));
     colorizer.init(Options::gpu.colorizer, mapDim);
     colorizer2.init(Options::gpu.colorizer, mapDim);
@@ -45,7 +45,7 @@ ImageMaker::init()
 void
 ImageMaker::draw(DrillMap &map)
 {
-    init();
+    init(map);
 
     auto rgba = RgbColor(Options::palette.bgColor);
 
@@ -112,7 +112,7 @@ ImageMaker::draw(DrillMap &map)
 void
 ImageMaker::draw(DrillMap &map1, DrillMap &map2, isize frame, float zoom)
 {
-    init();
+    init(map1);
 
     auto rgba = RgbColor(Options::palette.bgColor);
 
@@ -47,7 +47,7 @@ class ImageMaker {
 
 private:
 
-    void init();
+    void init(const DrillMap &map);
 
 
     //
@@ -85,6 +85,9 @@ public:
     void mute() { muted++; }
     void unmute() { muted--; }
 
+    // Indicates if the calling thread is allowed to produce output
+    bool isEnabled() const { return verbose(); }
+
     Logger& operator<<(const log::Endl &arg);
     Logger& operator<<(const log::VSpace &arg);
     Logger& operator<<(const log::Flush &arg);
@@ -37,6 +37,8 @@ Options::Approximation Options::approximation;
 Options::Areacheck Options::areacheck;
 Options::Attractorcheck Options::attractorcheck;
 Options::Periodcheck Options::periodcheck;
+Options::Interpolation Options::interpolation;
+Options::Autotune Options::autotune;
 
 std::map<string,string> Options::keys;
 std::vector<string> Options::overrides;
@@ -50,13 +52,21 @@ std::map<string,string> Options::defaults = [](){
     defaults["location.zoom"] = "1.0";
     defaults["location.depth"] = "800";
     defaults["location.escape"] = "1e32";
+    defaults["location.bailout"] = "1e3";
 
     // Map keys
     defaults["map.width"] = "1920";
     defaults["map.height"] = "1080";
+    defaults["map.tile"] = "";
 
     // Mapfile keys
     defaults["mapfile.compress"] = "yes";
+    defaults["mapfile.predict"] = "yes";
+    defaults["mapfile.shuffle"] = "yes";
+    defaults["mapfile.xorshuffle"] = "yes";
+    defaults["mapfile.precision"] = "single";
+    defaults["mapfile.tiled"] = "no";
+    defaults["mapfile.level"] = "0";
     defaults["mapfile.result"] = "yes";
     defaults["mapfile.first"] = "yes";
     defaults["mapfile.last"] = "yes";
@@ -107,6 +117,10 @@ std::map<string,string> Options::defaults = [](){
     defaults["perturbation.tolerance"] = "1e-6";
     defaults["perturbation.badpixels"] = "0.001";
     defaults["perturbation.rounds"] = "50";
+    defaults["perturbation.streaming"] = "yes";
+    defaults["perturbation.nucleus"] = "no";
+    defaults["perturbation.deadline"] = "0";
+    defaults["perturbation.inpaint"] = "no";
     defaults["perturbation.color"] = "";
 
     // Approximation keys
@@ -128,6 +142,16 @@ std::map<string,string> Options::defaults = [](){
     defaults["periodcheck.tolerance"] = "1e-74";
     defaults["periodcheck.color"] = "";
 
+    // Interpolation keys
+    defaults["interpolation.enable"] = "no";
+    defaults["interpolation.cellsize"] = "8";
+    defaults["interpolation.tolerance"] = "0.05";
+
+    // Autotune keys
+    defaults["autotune.enable"] = "no";
+    defaults["autotune.scale"] = "8";
+    defaults["autotune.tolerance"] = "0.001";
+
     return defaults;
 }();
 
@@ -204,6 +228,10 @@ Options::parse(string key, string value)
 
             Parser::parse(value, location.escape);
 
+        } else if (key == "location.bailout") {
+
+            Parser::parse(value, location.bailout);
+
         } else if (key == "map.width") {
 
             Parser::parse(value, drillmap.width, MIN_MAP_WIDTH, MAX_MAP_WIDTH);
@@ -212,10 +240,38 @@ Options::parse(string key, string value)
 
             Parser::parse(value, drillmap.height, MIN_MAP_HEIGHT, MAX_MAP_HEIGHT);
 
+        } else if (key == "map.tile") {
+
+            Parser::parse(value, drillmap.tile);
+
         } else if (key == "mapfile.compress") {
 
             Parser::parse(value, mapfile.compress);
 
+        } else if (key == "mapfile.predict") {
+
+            Parser::parse(value, mapfile.predict);
+
+        } else if (key == "mapfile.shuffle") {
+
+            Parser::parse(value, mapfile.shuffle);
+
+        } else if (key == "mapfile.xorshuffle") {
+
+            Parser::parse(value, mapfile.xorshuffle);
+
+        } else if (key == "mapfile.precision") {
+
+            Parser::parse(value, mapfile.precision);
+
+        } else if (key == "mapfile.tiled") {
+
+            Parser::parse(value, mapfile.tiled);
+
+        } else if (key == "mapfile.level") {
+
+            Parser::parse(value, mapfile.level, 0, 8);
+
         } else if (key == "mapfile.result") {
 
             Parser::parse(value, mapfile.result);
@@ -378,6 +434,30 @@ Options::parse(string key, string value)
 
             Parser::parse(value, periodcheck.color);
 
+        } else if (key == "interpolation.enable") {
+
+            Parser::parse(value, interpolation.enable);
+
+        } else if (key == "interpolation.cellsize") {
+
+            Parser::parse(value, interpolation.cellsize, 2, 256);
+
+        } else if (key == "interpolation.tolerance") {
+
+            Parser::parse(value, interpolation.tolerance);
+
+        } else if (key == "autotune.enable") {
+
+            Parser::parse(value, autotune.enable);
+
+        } else if (key == "autotune.scale") {
+
+            Parser::parse(value, autotune.scale, 1, 64);
+
+        } else if (key == "autotune.tolerance") {
+
+            Parser::parse(value, autotune.tolerance);
+
         } else if (key == "perturbation.enable") {
 
             Parser::parse(value, perturbation.enable);
@@ -394,6 +474,22 @@ Options::parse(string key, string value)
 
             Parser::parse(value, perturbation.rounds);
 
+        } else if (key == "perturbation.streaming") {
+
+            Parser::parse(value, perturbation.streaming);
+
+        } else if (key == "perturbation.nucleus") {
+
+            Parser::parse(value, perturbation.nucleus);
+
+        } else if (key == "perturbation.deadline") {
+
+            Parser::parse(value, perturbation.deadline);
+
+        } else if (key == "perturbation.inpaint") {
+
+            Parser::parse(value, perturbation.inpaint);
+
         } else if (key == "perturbation.color") {
 
             Parser::parse(value, perturbation.color);
@@ -453,6 +549,193 @@ Options::derive()
         auto zoom = ExtendedDouble(location.zoom);
         video.keyframes = isize(std::ceil(zoom.log2().asDouble()));
     }
+
+    // Derive the drill area
+    try {
+        deriveArea();
+    } catch (Exception &e) {
+        throw KeyValueError("map.tile", e.what());
+    }
+
+    // Determine the channels to be computed
+    deriveChannels();
+}
+
+void
+Options::deriveArea()
+{
+    auto &tile = drillmap.tile;
+    auto width = drillmap.width;
+    auto height = drillmap.height;
+
+    // By default, the entire map is drilled
+    drillmap.areaUL = Coord(isize(0), isize(0));
+    drillmap.areaLR = Coord(width - 1, height - 1);
+
+    if (tile == "") return;
+
+    if (auto pos = tile.find("/"); pos != std::string::npos) {
+
+        // Format "i/n": Split the map into n horizontal stripes
+        isize nr, count;
+        Parser::parse(tile.substr(0, pos), nr);
+        Parser::parse(tile.substr(pos + 1, std::string::npos), count, 1, height);
+
+        if (nr < 1 || nr > count) {
+            throw Exception("Tile number must be in the range 1..." + std::to_string(count));
+        }
+
+        drillmap.areaUL.y = i16((nr - 1) * height / count);
+        drillmap.areaLR.y = i16(nr * height / count - 1);
+        return;
+    }
+
+    // Format "x,y,w,h": Drill a rectangular area
+    auto values = split(tile, ',');
+    if (values.size() != 4) {
+        throw Exception("Expected format 'i/n' or 'x,y,w,h'");
+    }
+
+    isize x, y, w, h;
+    Parser::parse(values[0], x, 0, width - 1);
+    Parser::parse(values[1], y, 0, height - 1);
+    Parser::parse(values[2], w, 1, width - x);
+    Parser::parse(values[3], h, 1, height - y);
+
+    drillmap.areaUL = Coord(x, y);
+    drillmap.areaLR = Coord(x + w - 1, y + h - 1);
+}
+
+void
+Options::deriveChannels()
+{
+    /* Drill maps only allocate the channels which are saved to a map file,
+     * used by the GPU shaders, or needed by the driller itself. Derivatives
+     * are required to compute the normal vectors and the distance estimates.
+     */
+    bool first = false, nitcnt = false, derivative = false, normals = false, dist = false;
+
+    // Collects the names of all uniforms declared in a shader
+    auto uniforms = [](const fs::path &name) {
+
+        std::vector<string> result;
+
+        auto path = AssetManager::findAsset(name, Format::GLSL);
+        std::ifstream infile(path);
+        std::stringstream buffer;
+        buffer << infile.rdbuf();
+        auto source = buffer.str();
+
+        // Replace all comments by whitespace
+        for (usize i = 0; i + 1 < source.size(); i++) {
+
+            usize end;
+            if (source.compare(i, 2, "//") == 0) {
+                end = source.find('\n', i);
+            } else if (source.compare(i, 2, "/*") == 0) {
+                end = source.find("*/", i + 2);
+                if (end != string::npos) end += 2;
+            } else {
+                continue;
+            }
+
+            end = std::min(end, source.size());
+            std::fill(source.begin() + i, source.begin() + end, ' ');
+        }
+
+        // Each declaration may declare multiple uniforms (e.g., "uniform float a, b[2];")
+        for (const auto &declaration : split(source, ';')) {
+
+            std::istringstream stream(declaration);
+            std::vector<string> tokens;
+            for (string token; stream >> token;) tokens.push_back(token);
+
+            auto it = std::find(tokens.begin(), tokens.end(), "uniform");
+            if (it == tokens.end() || declaration.find('{') != string::npos) continue;
+
+            // Rejoin the type and the declarators
+            string rest;
+            for (++it; it != tokens.end(); ++it) rest += *it + " ";
+
+            auto declarators = split(rest, ',');
+            for (usize i = 0; i < declarators.size(); i++) {
+
+                // Strip array sizes and initializers
+                auto decl = declarators[i].substr(0, declarators[i].find_first_of("[="));
+
+                // The first declarator is preceded by the type
+                std::istringstream words(decl);
+                string word, name;
+                while (words >> word) { if (name.empty() || i == 0) name = word; }
+                if (!name.empty()) result.push_back(name);
+            }
+        }
+        return result;
+    };
+
+    // Adds the channels read by the colorizer and the illuminator
+    auto rendered = [&]() {
+
+        auto u = uniforms(gpu.colorizer);
+        auto declares = [&](const string &s) {
+            return std::find(u.begin(), u.end(), s) != u.end();
+        };
+
+        nitcnt |= declares("nitcnt");
+
+        // Normals are used for texture mapping and for 3D lighting
+        normals |= declares("normalRe") && (texture.image != "" || !declares("texture"));
+        if (lighting.enable) {
+
+            auto v = uniforms(gpu.illuminator);
+            normals |= std::find(v.begin(), v.end(), "normalRe") != v.end();
+        }
+
+        // Distance estimates are used to highlight the border
+        bool threshold = std::any_of(distance.threshold.yn.begin(),
+                                     distance.threshold.yn.end(),
+                                     [](double y) { return y != 0.0; });
+        dist |= declares("dist") && (threshold || !declares("distThreshold"));
+    };
+
+    for (const auto &it : files.outputs) {
+
+        auto format = AssetManager::getFormat(it);
+
+        if (format == Format::MAP) {
+
+            first |= mapfile.first;
+            nitcnt |= mapfile.nitcnt;
+            derivative |= mapfile.derivative;
+            normals |= mapfile.normal;
+            dist |= mapfile.dist;
+
+        } else if (AssetManager::isImageFormat(format) || AssetManager::isVideoFormat(format)) {
+
+            rendered();
+
+        } else {
+
+            first = nitcnt = derivative = normals = dist = true;
+        }
+    }
+
+    // Without outputs, DeepZoom renders a preview
+    if (files.outputs.empty()) rendered();
+
+    // Distance estimates and iteration counts guide the interpolation
+    nitcnt |= interpolation.enable;
+    dist |= interpolation.enable;
+
+    // Pilot maps are compared by their normalized iteration counts
+    nitcnt |= autotune.enable;
+
+    drillmap.first = first;
+    drillmap.nitcnt = nitcnt;
+    drillmap.dist = dist;
+    drillmap.derivative = derivative;
+    drillmap.normal = normals;
+    drillmap.derivatives = derivative || normals || dist;
 }
 
 }
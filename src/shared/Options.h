@@ -18,6 +18,7 @@
 #include "DynamicFloat.h"
 #include "ExtendedDouble.h"
 #include "PrecisionComplex.h"
+#include "Coord.h"
 
 namespace dd {
 
@@ -27,6 +28,13 @@ enum class ColoringMode
     Smooth
 };
 
+enum class FloatPrecision
+{
+    Single,
+    Half,
+    Quantized
+};
+
 struct Options {
 
     // Set to true to interrupt the application
@@ -82,6 +90,9 @@ struct Options {
         // Escape radius
         double escape;
 
+        // Radius at which escaping orbits are extrapolated to the escape radius
+        double bailout;
+
     } location;
 
     static struct Drillmap {
@@ -89,7 +100,24 @@ struct Options {
         // Drill map dimensions in pixels
         isize width;
         isize height;
-        
+
+        // Shard specification ("i/n" or "x,y,w,h")
+        string tile;
+
+        // Drill area derived from the shard specification (inclusive)
+        Coord areaUL;
+        Coord areaLR;
+
+        // Indicates if the outputs require derivatives (derived)
+        bool derivatives = true;
+
+        // Indicates which optional channels are required by the outputs (derived)
+        bool first = true;
+        bool nitcnt = true;
+        bool dist = true;
+        bool derivative = true;
+        bool normal = true;
+
     } drillmap;
 
     static struct Mapfile {
@@ -97,6 +125,24 @@ struct Options {
         // Indicates if map files should be saved in compressed format
         bool compress;
 
+        // Indicates if integer channels should be run through a predictor
+        bool predict;
+
+        // Indicates if floating-point channels should be split into byte planes
+        bool shuffle;
+
+        // Indicates if shuffled samples should be XORed with their predecessor
+        bool xorshuffle;
+
+        // Storage format of the normalized iteration counts and distance estimates
+        FloatPrecision precision;
+
+        // Indicates if map files should be saved in tiles with a mip pyramid
+        bool tiled;
+
+        // Mip level which is read from tiled map files
+        isize level;
+
         // Channels which are saved in the mapfile
         bool result;
         bool first;
@@ -214,6 +260,20 @@ struct Options {
         // Maximum number of rounds
         isize rounds;
 
+        // Indicates if delta orbits are computed while the reference orbit is
+        // still under construction
+        bool streaming;
+
+        // Indicates if the first reference point is placed at a minibrot
+        // nucleus inside the drill area
+        bool nucleus;
+
+        // Time budget for drilling in seconds (0 = unlimited)
+        double deadline;
+
+        // Indicates if the remaining glitches are resolved in a final pass
+        bool inpaint;
+
         // Optional debug color for glitch points
         std::optional<GpuColor> color;
 
@@ -268,6 +328,32 @@ struct Options {
 
     } periodcheck;
 
+    static struct Interpolation {
+
+        // Indicates if smooth exterior regions should be interpolated
+        bool enable;
+
+        // Spacing of the coarse grid in pixels
+        isize cellsize;
+
+        // Maximum deviation of the normalized iteration count
+        double tolerance;
+
+    } interpolation;
+
+    static struct Autotune {
+
+        // Indicates if the drill parameters are optimized in a pilot run
+        bool enable;
+
+        // Downscaling factor of the pilot map
+        isize scale;
+
+        // Maximum fraction of pixels that may deviate from the original setting
+        double tolerance;
+
+    } autotune;
+
 
     //
     // Initialization
@@ -295,6 +381,11 @@ public:
     static void parse(string key, string value);
     static void applyDefaults();
     static void derive();
+
+private:
+
+    static void deriveArea();
+    static void deriveChannels();
 };
 
 }
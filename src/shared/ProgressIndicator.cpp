@@ -15,6 +15,9 @@
 #include "Logger.h"
 #include "Options.h"
 
+#include <iomanip>
+#include <unistd.h>
+
 namespace dd {
 
 ProgressIndicator::ProgressIndicator(const string &description, isize max)
@@ -30,6 +33,8 @@ ProgressIndicator::~ProgressIndicator()
 void
 ProgressIndicator::init(const string &desc, isize max)
 {
+    done();
+
     description = desc;
     progress = 0;
     progressMax = max;
@@ -40,34 +45,87 @@ ProgressIndicator::init(const string &desc, isize max)
     log::cout << log::ralign(description + ": ");
     log::cout << log::flush;
     clock.restart();
-}
 
-void
-ProgressIndicator::step(isize delta)
-{
-    if (clock.isPaused()) return;
+    active = true;
+    live = isatty(STDOUT_FILENO);
 
-    progress += delta;
-
-    isize newDots = dotsMax * progress / progressMax;
-    for (; dots < newDots; dots++) { log::cout << "."; }
-    log::cout << log::flush;
+    // Only render the progress bar if the calling thread is allowed to print
+    if (log::cout.isEnabled()) reporter = std::thread(&ProgressIndicator::report, this);
 }
 
 void
 ProgressIndicator::done(const string &info)
 {
-    if (clock.isPaused()) return;
+    if (!active) return;
+
+    // Stop the reporter thread
+    {   std::lock_guard<std::mutex> lock(mutex);
+        active = false;
+    }
+    cond.notify_all();
+    if (reporter.joinable()) reporter.join();
 
     auto elapsed = clock.stop();
-        
+
+    // Remove the live statistics
+    if (live) log::cout << "\r" << log::ralign(description + ": ") << string(dots, '.');
+
     for (; dots < dotsMax; dots++) { log::cout << "."; } log::cout << " ";
     log::cout << elapsed;
     
     if (info != "") log::cout << " (" << info << ")";
+    if (live) log::cout << "\033[K";
     log::cout << log::endl;
 }
 
+void
+ProgressIndicator::report()
+{
+    // The owner thread has been verified to be allowed to print
+    Logger logger(std::cout);
+    auto start = Time::now();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!cond.wait_for(lock, std::chrono::milliseconds(250), [this]() { return !active; })) {
+        render(logger, Time::now() - start);
+    }
+}
+
+void
+ProgressIndicator::render(Logger &logger, Time elapsed)
+{
+    auto current = std::min(progress.load(std::memory_order_relaxed), progressMax);
+    auto newDots = progressMax ? dotsMax * current / progressMax : 0;
+
+    if (!live) {
+
+        // Append the new dots
+        for (; dots < newDots; dots++) { logger << "."; }
+        logger << log::flush;
+        return;
+    }
+
+    // Redraw the line and append the throughput and the estimated time left
+    dots = newDots;
+    logger << "\r" << log::ralign(description + ": ") << string(dots, '.');
+
+    auto seconds = elapsed.asSeconds();
+    if (current && seconds > 0) {
+
+        auto rate = double(current) / seconds;
+        auto eta = Time::seconds(std::min(float((progressMax - current) / rate), 360000.0f));
+
+        std::stringstream ss;
+        ss << std::fixed << std::setprecision(1);
+        if (rate >= 1e6) { ss << rate / 1e6 << "M/s"; }
+        else if (rate >= 1e3) { ss << rate / 1e3 << "K/s"; }
+        else { ss << rate << "/s"; }
+
+        logger << " " << ss.str() << ", ETA " << eta;
+    }
+    logger << "\033[K" << log::flush;
+}
+
 BatchProgressIndicator::BatchProgressIndicator(const string &msg, const fs::path &path)
 {
     if (Options::flags.batch) {
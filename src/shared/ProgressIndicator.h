@@ -15,6 +15,11 @@
 #include "Chrono.h"
 #include "Logger.h"
 
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
 namespace dd {
 
 class ProgressIndicator {
@@ -22,17 +27,28 @@ class ProgressIndicator {
     // Description
     string description;
     
-    // Progress
-    isize progress;
-    isize progressMax;
+    // Progress (may be updated by multiple threads)
+    std::atomic<isize> progress = 0;
+    isize progressMax = 0;
     
     // Printed dots
-    isize dots;
-    isize dotsMax;
+    isize dots = 0;
+    isize dotsMax = 33;
     
     // Stop watch
     Clock clock;
-        
+
+    // Indicates if the indicator has been initialized and not finished yet
+    bool active = false;
+
+    // Indicates if statistics are shown while running (terminal output only)
+    bool live = false;
+
+    // Reporter thread (renders the progress bar in the background)
+    std::thread reporter;
+    std::mutex mutex;
+    std::condition_variable cond;
+
 
     //
     // Methods
@@ -44,12 +60,20 @@ public:
     ProgressIndicator(const string &description, isize max = 100);
     ~ProgressIndicator();
 
-    void step(isize delta = 1);
+    void step(isize delta = 1) { progress.fetch_add(delta, std::memory_order_relaxed); }
     void done(const string &info = "");
 
 // private:
     
     void init(const string &description, isize max = 100);
+
+private:
+
+    // Main function of the reporter thread
+    void report();
+
+    // Redraws the progress bar
+    void render(Logger &logger, Time elapsed);
 };
 
 class BatchProgressIndicator {
@@ -12,13 +12,40 @@
 #include "Compressor.h"
 #include "Exception.h"
 #include "miniz.h"
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
 
 namespace dd {
 
 bool
 Compressor::eof()
 {
-    return ptr == isize(buffer.size());
+    return ptr == size() && (!incremental || nextChunk == isize(rawOffsets.size()) - 1);
+}
+
+u8 *
+Compressor::append(isize count)
+{
+    assert(!external);
+
+    auto offset = buffer.size();
+    buffer.resize(offset + count);
+    return buffer.data() + offset;
+}
+
+const u8 *
+Compressor::consume(isize count)
+{
+    if (ptr + count > size() && incremental) refill(count);
+    if (ptr + count > size()) {
+        throw Exception("Compressor: Unexpected end of data");
+    }
+
+    auto result = data() + ptr;
+    ptr += count;
+    return result;
 }
 
 Compressor&
@@ -32,6 +59,7 @@ Compressor::operator<<(std::istream &is)
     auto size = last - current;
 
     // Read data
+    external = nullptr;
     buffer.resize(size);
     if (!is.read((char *)buffer.data(), size)) {
         throw Exception("Compressor: Can't read from stream");
@@ -43,52 +71,193 @@ Compressor::operator<<(std::istream &is)
 Compressor&
 Compressor::operator>>(std::ostream &os)
 {
-    os.write((char *)buffer.data(), buffer.size());
+    os.write((char *)data(), size());
     return *this;
 }
 
 void
 Compressor::compressData()
 {
-    // Create a second buffer
-    std::vector<u8> target(capacity);
+    /* The buffer is split into independently deflated chunks of chunkSize
+     * bytes. The compressed buffer starts with a chunk index (the number of
+     * chunks followed by the raw and compressed size of each chunk) which
+     * enables the chunks to be uncompressed in parallel.
+     */
+    std::vector<isize> starts;
+    for (isize pos = 0; pos < size(); pos += chunkSize) starts.push_back(pos);
+    starts.push_back(size());
+
+    auto count = isize(starts.size()) - 1;
+    std::vector<std::vector<u8>> chunks(count);
+    std::atomic<int> error = MZ_OK;
+
+    // Compress all chunks in parallel
+    parallel(count, [&](isize i) {
+
+        auto rawLen = mz_ulong(starts[i + 1] - starts[i]);
+        auto packedLen = mz_compressBound(rawLen);
 
-    auto bufferLen = mz_ulong(buffer.size());
-    auto targetLen = mz_ulong(target.size());
+        chunks[i].resize(packedLen);
+        auto result = mz_compress(chunks[i].data(), &packedLen, data() + starts[i], rawLen);
+        if (result != MZ_OK) error = result;
+        chunks[i].resize(packedLen);
+    });
 
-    // Run the compressor
-    auto result = mz_compress(target.data(), &targetLen, buffer.data(), bufferLen);
-    if (result != MZ_OK) {
-        throw Exception("Compression failed with error code " + std::to_string(result));
+    if (error != MZ_OK) {
+        throw Exception("Compression failed with error code " + std::to_string(error));
     }
 
-    // Resize the target buffer to it's actual size
-    target.resize(targetLen);
+    // Assemble the chunk index and the compressed chunks
+    std::vector<u8> target;
+    auto write = [&](u32 value) {
+        target.insert(target.end(), (u8 *)&value, (u8 *)&value + sizeof(value));
+    };
+
+    write(u32(count));
+    for (isize i = 0; i < count; i++) {
+
+        write(u32(starts[i + 1] - starts[i]));
+        write(u32(chunks[i].size()));
+    }
+    for (auto &chunk : chunks) {
+        target.insert(target.end(), chunk.begin(), chunk.end());
+    }
 
     // Replace original data with compressed data
     buffer.swap(target);
+    external = nullptr;
+    ptr = 0;
 }
 
 void
 Compressor::uncompressData()
 {
-    // Create a second buffer
-    std::vector<u8> target(capacity);
+    auto count = readIndex();
 
-    auto bufferLen = mz_ulong(buffer.size());
-    auto targetLen = mz_ulong(target.size());
+    // Uncompress all chunks in parallel
+    std::vector<u8> target(rawOffsets[count]);
+    uncompressChunks(0, count, target.data());
 
-    // Run the uncompressor
-    auto result = mz_uncompress(target.data(), &targetLen, buffer.data(), bufferLen);
-    if (result != MZ_OK) {
-        throw Exception("Uncompression failed with error code " + std::to_string(result));
+    // Replace original data with uncompressed data
+    buffer.swap(target);
+    external = nullptr;
+    ptr = 0;
+}
+
+void
+Compressor::uncompressIncrementally()
+{
+    readIndex();
+
+    // Keep the compressed data while the buffer holds a window of uncompressed data
+    if (!external) {
+
+        auto offset = packed - buffer.data();
+        source.swap(buffer);
+        packed = source.data() + offset;
     }
 
-    // Resize the target buffer to it's actual size
-    target.resize(targetLen);
+    buffer.clear();
+    external = nullptr;
+    nextChunk = 0;
+    incremental = true;
+    ptr = 0;
+}
 
-    // Replace original data with compressed data
-    buffer.swap(target);
+isize
+Compressor::readIndex()
+{
+    auto read = [&]() { u32 value; std::memcpy(&value, consume(sizeof(value)), sizeof(value)); return isize(value); };
+
+    auto count = read();
+    rawOffsets.assign(count + 1, 0);
+    packedOffsets.assign(count + 1, 0);
+
+    for (isize i = 0; i < count; i++) {
+
+        rawOffsets[i + 1] = rawOffsets[i] + read();
+        packedOffsets[i + 1] = packedOffsets[i] + read();
+    }
+
+    if (ptr + packedOffsets[count] > size()) {
+        throw Exception("Compressor: Corrupted chunk index");
+    }
+    packed = data() + ptr;
+
+    return count;
+}
+
+void
+Compressor::uncompressChunks(isize first, isize last, u8 *target)
+{
+    std::atomic<int> error = MZ_OK;
+
+    parallel(last - first, [&](isize j) {
+
+        auto i = first + j;
+        auto rawLen = mz_ulong(rawOffsets[i + 1] - rawOffsets[i]);
+        auto packedLen = mz_ulong(packedOffsets[i + 1] - packedOffsets[i]);
+
+        auto result = mz_uncompress(target + rawOffsets[i] - rawOffsets[first], &rawLen,
+                                    packed + packedOffsets[i], packedLen);
+        if (result == MZ_OK && rawLen != mz_ulong(rawOffsets[i + 1] - rawOffsets[i])) result = MZ_DATA_ERROR;
+        if (result != MZ_OK) error = result;
+    });
+
+    if (error != MZ_OK) {
+        throw Exception("Uncompression failed with error code " + std::to_string(error));
+    }
+}
+
+void
+Compressor::refill(isize count)
+{
+    auto numThreads = isize(std::max(1U, std::thread::hardware_concurrency()));
+    auto numChunks = isize(rawOffsets.size()) - 1;
+
+    // Discard all consumed bytes
+    buffer.erase(buffer.begin(), buffer.begin() + ptr);
+    ptr = 0;
+
+    // Append the next batch of chunks until enough data is available
+    while (size() < count && nextChunk < numChunks) {
+
+        auto last = std::min(nextChunk + numThreads, numChunks);
+        auto offset = size();
+
+        buffer.resize(offset + rawOffsets[last] - rawOffsets[nextChunk]);
+        uncompressChunks(nextChunk, last, buffer.data() + offset);
+        nextChunk = last;
+    }
+}
+
+void
+Compressor::parallel(isize count, const std::function<void(isize)> &func)
+{
+    auto numThreads = std::min(count, isize(std::max(1U, std::thread::hardware_concurrency())));
+    std::atomic<isize> next = 0;
+    std::exception_ptr error;
+    std::mutex mutex;
+
+    auto worker = [&]() {
+
+        try {
+            for (isize i = next++; i < count; i = next++) func(i);
+        } catch (...) {
+
+            // Stop all workers and pass the exception to the calling thread
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!error) error = std::current_exception();
+            next = count;
+        }
+    };
+
+    {   std::vector<std::jthread> threads;
+        for (isize nr = 1; nr < numThreads; nr++) threads.push_back(std::jthread(worker));
+        worker();
+    }
+
+    if (error) std::rethrow_exception(error);
 }
 
 }
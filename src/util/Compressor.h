@@ -14,22 +14,47 @@
 #include "config.h"
 #include "Types.h"
 
+#include <cstring>
+#include <functional>
+
 namespace dd {
 
 class Compressor {
-    
+
+    // Maximum number of bytes that are deflated as a single chunk
+    static constexpr isize chunkSize = 1024 * 1024;
+
     isize capacity = 0;
     isize ptr = 0;
 
     std::vector <u8> buffer;
 
+    // Externally owned data which is read instead of the buffer (if set)
+    u8 *external = nullptr;
+    isize externalSize = 0;
+
+    // Chunk index of the compressed data (prefix sums of the chunk sizes)
+    std::vector <isize> rawOffsets;
+    std::vector <isize> packedOffsets;
+    const u8 *packed = nullptr;
+
+    // Compressed data (if the uncompressed data is produced incrementally)
+    std::vector <u8> source;
+
+    // Next chunk to uncompress (if the uncompressed data is produced incrementally)
+    isize nextChunk = 0;
+    bool incremental = false;
+
 public:
 
-    Compressor(isize capacity) : capacity(capacity) { }
+    Compressor(isize capacity) : capacity(capacity) { buffer.reserve(capacity); }
+    Compressor(u8 *data, isize size) : external(data), externalSize(size) { }
     ~Compressor() { };
 
     bool eof();
-    isize size() { return (isize)buffer.size(); }
+    isize size() { return external ? externalSize : (isize)buffer.size(); }
+    isize tell() { return ptr; }
+    u8 *data() { return external ? external : buffer.data(); }
 
     Compressor& operator<<(const i8 &value) { write(value); return *this; }
     Compressor& operator<<(const u8 &value) { write(value); return *this; }
@@ -51,27 +76,40 @@ public:
     Compressor& operator>>(double &value) { read(value); return *this; }
     Compressor& operator>>(std::ostream &os);
 
+    // Enlarges the buffer by a block of bytes and returns a pointer to it
+    u8 *append(isize count);
+
+    // Skips a block of bytes and returns a pointer to it
+    const u8 *consume(isize count);
+
     void compressData();
     void uncompressData();
 
+    // Uncompresses chunks on demand while the data is consumed
+    void uncompressIncrementally();
+
+    // Runs func(0) ... func(count - 1) on multiple threads (rethrows the first exception)
+    static void parallel(isize count, const std::function<void(isize)> &func);
+
 private:
 
-    template <typename T> void write(T value) {
+    // Reads the chunk index of the compressed data
+    isize readIndex();
 
-        u8 *p = (u8 *)&value;
+    // Uncompresses chunks first ... last - 1 in parallel
+    void uncompressChunks(isize first, isize last, u8 *target);
 
-        for (isize i = 0; i < isizeof(T); i++) {
-            buffer.push_back(p[i]);
-        }
+    // Uncompresses chunks until at least count bytes are available
+    void refill(isize count);
+
+    template <typename T> void write(T value) {
+
+        std::memcpy(append(isizeof(T)), &value, sizeof(T));
     }
     
     template <typename T> void read(T &value) {
 
-        u8 *p = (u8 *)&value;
-
-        for (isize i = 0; i < isizeof(T); i++) {
-            p[i] = buffer[ptr++];
-        }
+        std::memcpy(&value, consume(isizeof(T)), sizeof(T));
     }
 };
 
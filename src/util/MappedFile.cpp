@@ -0,0 +1,57 @@
+// -----------------------------------------------------------------------------
+// This file is part of DeepDrill
+//
+// A Mandelbrot generator based on perturbation and series approximation
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v3
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#include "MappedFile.h"
+#include "Exception.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace dd {
+
+MappedFile::MappedFile(const fs::path &path)
+{
+    auto fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) throw Exception("Failed to read file " + path.string());
+
+    struct stat info;
+    if (fstat(fd, &info) == 0 && info.st_size > 0) {
+
+        auto addr = mmap(nullptr, info.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        if (addr != MAP_FAILED) {
+
+            bytes = (u8 *)addr;
+            length = isize(info.st_size);
+        }
+    }
+    close(fd);
+
+    if (!bytes) throw Exception("Failed to map file " + path.string());
+}
+
+MappedFile::~MappedFile()
+{
+    if (bytes) munmap(bytes, length);
+}
+
+void
+MappedFile::release(isize offset, isize count)
+{
+    // Only release pages which are entirely covered by the range
+    auto page = isize(sysconf(_SC_PAGESIZE));
+    auto first = (offset + page - 1) / page * page;
+    auto last = std::min(offset + count, length) / page * page;
+
+    if (first < last) madvise(bytes + first, last - first, MADV_DONTNEED);
+}
+
+}
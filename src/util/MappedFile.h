@@ -0,0 +1,42 @@
+// -----------------------------------------------------------------------------
+// This file is part of DeepDrill
+//
+// A Mandelbrot generator based on perturbation and series approximation
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v3
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#pragma once
+
+#include "config.h"
+#include "Types.h"
+
+namespace dd {
+
+/* Maps a file into memory. The mapping is private, i.e., the contents may be
+ * modified in place without affecting the file on disk. Pages are only copied
+ * when they get written to.
+ */
+class MappedFile {
+
+    u8 *bytes = nullptr;
+    isize length = 0;
+
+public:
+
+    MappedFile(const fs::path &path);
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+    ~MappedFile();
+
+    u8 *data() const { return bytes; }
+    isize size() const { return length; }
+
+    // Returns the pages of a consumed range to the operating system
+    void release(isize offset, isize count);
+};
+
+}
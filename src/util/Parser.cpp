@@ -262,6 +262,23 @@ Parser::parse(const string &value, ColoringMode &parsed)
     }
 }
 
+void
+Parser::parse(const string &value, FloatPrecision &parsed)
+{
+    std::map <string, FloatPrecision> modes = {
+
+        { "single",     FloatPrecision::Single    },
+        { "half",       FloatPrecision::Half      },
+        { "quantized",  FloatPrecision::Quantized }
+    };
+
+    try {
+        parsed = modes.at(value);
+    } catch (...) {
+        throw Exception("Unknown precision: '" + value + "'");
+    }
+}
+
 void
 Parser::parse(const string &value, DynamicFloat &parsed)
 {
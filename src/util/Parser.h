@@ -48,6 +48,7 @@ public:
     static void parse(const string &value, GpuColor &parsed);
     static void parse(const string &value, std::optional<GpuColor> &parsed);
     static void parse(const string &value, ColoringMode &parsed);
+    static void parse(const string &value, FloatPrecision &parsed);
     static void parse(const string &value, DynamicFloat &parsed);
     static void parse(const string &value, Time &parsed);
     static void parse(const string &value, std::pair<isize,isize> &parsed);